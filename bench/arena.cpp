@@ -0,0 +1,124 @@
+// Benchmark of building, evaluating and freeing expression trees, such as a
+// parser would make for each request.
+//
+// By default, the nodes are held in `recursive_wrapper`, so each node is a
+// separate `new`, and each tree is freed by a recursive chain of `delete`s.
+// With -DARENA, they are held in `arena_wrapper`, and each tree is freed by
+// releasing the arena.
+
+#include "bench_api.hpp"
+#include <strict_variant/arena_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+#ifdef ARENA
+template <typename T>
+using wrapper_t = strict_variant::arena_wrapper<T>;
+#else
+template <typename T>
+using wrapper_t = strict_variant::recursive_wrapper<T>;
+#endif
+
+struct add;
+struct mul;
+
+// With `blank`, moving an `expr` takes the pointer instead of moving the node
+using expr =
+  strict_variant::variant<uint32_t, strict_variant::blank, wrapper_t<add>, wrapper_t<mul>>;
+
+struct add {
+  expr lhs;
+  expr rhs;
+};
+
+struct mul {
+  expr lhs;
+  expr rhs;
+};
+
+struct evaluator {
+  uint32_t operator()(uint32_t i) const { return i; }
+  uint32_t operator()(strict_variant::blank) const { return 0; }
+  uint32_t operator()(const add & a) const {
+    return strict_variant::apply_visitor(*this, a.lhs)
+           + strict_variant::apply_visitor(*this, a.rhs);
+  }
+  uint32_t operator()(const mul & m) const {
+    return strict_variant::apply_visitor(*this, m.lhs)
+           * strict_variant::apply_visitor(*this, m.rhs);
+  }
+};
+
+// Builds a tree with `n` leaves, with shape and values taken from `choices`
+expr
+build(const uint32_t *& choices, uint32_t n) {
+  const uint32_t x = *choices++;
+  if (n <= 1) { return expr{x}; }
+  const uint32_t left = 1 + x % (n - 1);
+  expr lhs = build(choices, left);
+  expr rhs = build(choices, n - left);
+  if (x & 1) { return expr{add{std::move(lhs), std::move(rhs)}}; }
+  return expr{mul{std::move(lhs), std::move(rhs)}};
+}
+
+int
+main() {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  std::mt19937 rng{rng_seed};
+  std::vector<uint32_t> choices;
+  choices.reserve(2 * seq_length);
+  for (uint32_t i = 0; i < 2 * seq_length; ++i) {
+    choices.push_back(static_cast<uint32_t>(rng()));
+  }
+
+#ifdef ARENA
+  const char * name = "strict_variant expression trees (arena_wrapper)";
+  strict_variant::monotonic_arena arena;
+#else
+  const char * name = "strict_variant expression trees (recursive_wrapper)";
+#endif
+
+  std::fprintf(stdout, "%s:\n  seq_length = %u\n  repeat_num = %u\n  sizeof = %u\n\n", name,
+               seq_length, repeat_num, static_cast<unsigned>(sizeof(expr)));
+
+  uint32_t checksum = 0;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+#ifdef ARENA
+    strict_variant::arena_scope scope{arena};
+#endif
+    {
+      const uint32_t * c = choices.data();
+      expr tree = build(c, seq_length);
+      checksum += strict_variant::apply_visitor(evaluator{}, tree);
+      benchmark::ClobberMemory();
+    }
+#ifdef ARENA
+    arena.release();
+#endif
+  }
+
+  auto const end = clock_t::now();
+
+  // Nodes: `seq_length` leaves, and one fewer interior nodes
+  const double num_nodes = static_cast<double>(2 * seq_length - 1) * repeat_num;
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "checksum = %u\n", checksum);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per node: %f\n\n\n",
+               (static_cast<double>(us) / num_nodes) * 1000);
+}
@@ -0,0 +1,116 @@
+// Benchmark of the memory footprint of a variant with one large, rarely used
+// alternative, and the effect of that on a linear scan over many of them.
+//
+// By default the sequence holds `strict_variant::variant`, so every element is
+// as large as the largest alternative. With -DCOMPACT_VARIANT, it holds
+// `strict_variant::compact_variant`, which puts the large alternative on the
+// heap.
+
+#include "bench_api.hpp"
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static constexpr uint32_t seq_length{SEQ_LENGTH * 10};
+static constexpr uint32_t repeat_num{REPEAT_NUM / 10};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+// Percentage of the elements which hold the large type
+static constexpr uint32_t big_percent{1};
+
+static constexpr std::size_t budget{16};
+
+struct small_struct {
+  uint32_t a, b;
+};
+
+struct big_config {
+  uint32_t values[64];
+};
+
+#ifdef COMPACT_VARIANT
+using var_t = strict_variant::compact_variant<budget, uint32_t, double, small_struct, big_config>;
+#else
+using var_t = strict_variant::variant<uint32_t, double, small_struct, big_config>;
+#endif
+
+struct visitor {
+  uint32_t operator()(uint32_t x) const noexcept { return x; }
+  uint32_t operator()(double d) const noexcept { return static_cast<uint32_t>(d); }
+  uint32_t operator()(const small_struct & s) const noexcept { return s.a ^ s.b; }
+  uint32_t operator()(const big_config & c) const noexcept { return c.values[0]; }
+};
+
+std::vector<var_t>
+make_sequence(uint32_t seed) {
+  std::mt19937 rng{seed};
+  std::vector<var_t> result;
+  result.reserve(seq_length);
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    const uint32_t x = static_cast<uint32_t>(rng());
+    if (x % 100 < big_percent) {
+      big_config c{};
+      c.values[0] = x;
+      result.emplace_back(c);
+    } else {
+      switch (x % 3) {
+        case 0: result.emplace_back(x); break;
+        case 1: result.emplace_back(static_cast<double>(x)); break;
+        default: result.emplace_back(small_struct{x, x >> 3}); break;
+      }
+    }
+  }
+  return result;
+}
+
+int
+main() {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  const std::vector<var_t> sequence = make_sequence(rng_seed);
+
+  std::size_t num_big = 0;
+  for (const auto & v : sequence) {
+    if (v.which() == 3) { ++num_big; }
+  }
+
+#ifdef COMPACT_VARIANT
+  const char * name = "strict_variant footprint (compact_variant)";
+  const std::size_t heap_bytes = num_big * sizeof(big_config);
+#else
+  const char * name = "strict_variant footprint (variant)";
+  const std::size_t heap_bytes = 0;
+#endif
+
+  const std::size_t inline_bytes = sequence.size() * sizeof(var_t);
+
+  std::fprintf(stdout, "%s:\n  seq_length = %u\n  repeat_num = %u\n  big_percent = %u\n",
+               name, seq_length, repeat_num, big_percent);
+  std::fprintf(stdout, "  sizeof = %u\n  inline_kb = %u\n  heap_kb = %u\n  total_kb = %u\n\n",
+               static_cast<unsigned>(sizeof(var_t)), static_cast<unsigned>(inline_bytes / 1024),
+               static_cast<unsigned>(heap_bytes / 1024),
+               static_cast<unsigned>((inline_bytes + heap_bytes) / 1024));
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    uint32_t sum = 0;
+    for (const auto & v : sequence) {
+      sum += strict_variant::apply_visitor(visitor{}, v);
+    }
+    benchmark::DoNotOptimize(sum);
+    benchmark::ClobberMemory();
+  }
+
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per visit: %f\n\n\n",
+               (static_cast<double>(us) / (static_cast<double>(seq_length) * repeat_num)) * 1000);
+}
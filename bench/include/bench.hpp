@@ -1,6 +1,7 @@
 #pragma once
 
 #include "bench_api.hpp"
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <random>
@@ -15,12 +16,20 @@ namespace benchmark {
 template <uint32_t N>
 struct dummy {};
 
+// The branchless dispatch policy of strict_variant requires a noexcept
+// visitor, the other benchmarks use the visitor as it is
+#ifdef NOEXCEPT_VISIT
+#define BENCH_VISIT_NOEXCEPT noexcept
+#else
+#define BENCH_VISIT_NOEXCEPT
+#endif
+
 // Dummy visitor
 struct visitor {
   using result_type = uint32_t;
 
   template <uint32_t N>
-  uint32_t operator()(const dummy<N> &) const {
+  uint32_t operator()(const dummy<N> &) const BENCH_VISIT_NOEXCEPT {
     uint32_t result{N};
 #ifdef OPAQUE_VISIT
     // This makes the return value of the visitor opaque to the optimizer
@@ -125,9 +134,22 @@ struct bench_task {
       seed -= (seed >> 3);
     }*/
     std::mt19937 rng{seed};
-    for (var_t & v : sequence_) {
-      uint32_t x = static_cast<uint32_t>(rng());
-      set_type<variant_template, num_variants>(v, x);
+    std::array<uint32_t, seq_length> types;
+    for (uint32_t & x : types) {
+      x = static_cast<uint32_t>(rng());
+#ifdef HOT_PERCENT
+      // Skewed distribution: HOT_PERCENT percent of the variants hold type 0 or 1,
+      // the rest are uniformly distributed over all the types.
+      if (static_cast<uint32_t>(rng()) % 100 < HOT_PERCENT) { x %= 2; }
+#endif
+      x %= num_variants;
+    }
+#ifdef SORTED_SEQUENCE
+    // Clustered distribution: the variants are grouped by type
+    std::sort(types.begin(), types.end());
+#endif
+    for (uint32_t i = 0; i < seq_length; ++i) {
+      set_type<variant_template, num_variants>(sequence_[i], types[i]);
     }
   }
 
@@ -141,6 +163,16 @@ struct bench_task {
       benchmark::ClobberMemory();
     }
   }
+
+  // Visits the whole sequence in one call, for batch visitation APIs.
+  // RV is called with a pair of iterators.
+  template <typename RV>
+  void run_range(RV && apply_visitor_range) const {
+    benchmark::ClobberMemory();
+    benchmark::DoNotOptimize(
+      std::forward<RV>(apply_visitor_range)(sequence_.begin(), sequence_.end()));
+    benchmark::ClobberMemory();
+  }
 };
 
 } // end namespace benchmark
@@ -22,8 +22,20 @@ run_benchmark(const char * variant_name, const uint32_t seed) {
   using BenchTask_t = bench_task<var_t, num_variants, seq_length>;
   BenchTask_t task{seed};
 
-  std::fprintf(stdout, "%s:\n  num_variants = %u\n  seq_length = %u\n  repeat_num = %u\n\n",
+  std::fprintf(stdout, "%s:\n  num_variants = %u\n  seq_length = %u\n  repeat_num = %u\n",
                variant_name, num_variants, seq_length, repeat_num);
+  std::fprintf(stdout, "  sizeof = %u\n",
+               static_cast<unsigned>(sizeof(typename BenchTask_t::var_t)));
+#ifdef HOT_PERCENT
+  std::fprintf(stdout, "  hot_percent = %u\n", static_cast<unsigned>(HOT_PERCENT));
+#endif
+#ifdef SORTED_SEQUENCE
+  std::fprintf(stdout, "  sorted = true\n");
+#endif
+#ifdef RANGE_VISIT
+  std::fprintf(stdout, "  range_visit = true\n");
+#endif
+  std::fprintf(stdout, "\n");
 
   benchmark::DoNotOptimize(task);
 
@@ -32,7 +44,11 @@ run_benchmark(const char * variant_name, const uint32_t seed) {
   benchmark::ClobberMemory();
 
   for (uint32_t count{repeat_num}; count; --count) {
+#ifdef RANGE_VISIT
+    task.run_range(VisitorApplier{});
+#else
     task.run(VisitorApplier{});
+#endif
   }
 
   auto const end = ClockType::now();
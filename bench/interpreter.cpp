@@ -0,0 +1,187 @@
+// Benchmark of a small register-machine bytecode interpreter, whose
+// instructions are a strict_variant::variant of opcode structs.
+//
+// By default the program is run with `strict_variant::interpret`, which uses
+// computed-goto threading where available. With -DINTERPRETER_LOOP, it is run
+// with a loop over `apply_visitor` instead, for comparison.
+
+#include "bench_api.hpp"
+#include <strict_variant/interpreter.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static constexpr uint32_t program_length{1000};
+static constexpr uint32_t repeat_num{REPEAT_NUM * 10};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+namespace vm {
+
+static constexpr uint32_t num_registers{8};
+
+// Opcodes
+struct load {
+  uint32_t dest;
+  uint32_t value;
+};
+struct add {
+  uint32_t dest, src;
+};
+struct sub {
+  uint32_t dest, src;
+};
+struct mul {
+  uint32_t dest, src;
+};
+struct bxor {
+  uint32_t dest, src;
+};
+struct shr {
+  uint32_t dest;
+  uint32_t amount;
+};
+struct skip_if_odd {
+  uint32_t src;
+};
+// Decrement the register, and jump by `offset` if it is not zero.
+struct dec_jnz {
+  uint32_t reg;
+  int32_t offset;
+};
+
+using instruction = strict_variant::variant<load, add, sub, mul, bxor, shr, skip_if_odd, dec_jnz>;
+
+struct machine {
+  uint32_t regs[num_registers];
+
+  int operator()(const load & i) {
+    regs[i.dest] = i.value;
+    return 1;
+  }
+  int operator()(const add & i) {
+    regs[i.dest] += regs[i.src];
+    return 1;
+  }
+  int operator()(const sub & i) {
+    regs[i.dest] -= regs[i.src];
+    return 1;
+  }
+  int operator()(const mul & i) {
+    regs[i.dest] *= regs[i.src];
+    return 1;
+  }
+  int operator()(const bxor & i) {
+    regs[i.dest] ^= regs[i.src];
+    return 1;
+  }
+  int operator()(const shr & i) {
+    regs[i.dest] >>= i.amount;
+    return 1;
+  }
+  int operator()(const skip_if_odd & i) { return (regs[i.src] & 1) ? 2 : 1; }
+  int operator()(const dec_jnz & i) { return --regs[i.reg] ? i.offset : 1; }
+};
+
+// Random straight-line body, followed by a loop back to the start.
+// The last register is reserved as the loop counter.
+std::vector<instruction>
+make_program(uint32_t seed) {
+  std::mt19937 rng{seed};
+  std::vector<instruction> result;
+  const uint32_t r = num_registers - 1;
+  for (uint32_t i = 0; i < r; ++i) {
+    result.emplace_back(load{i, static_cast<uint32_t>(rng())});
+  }
+  result.emplace_back(load{r, repeat_num});
+  const int32_t loop_start = static_cast<int32_t>(result.size());
+
+  while (result.size() < program_length - 1) {
+    const uint32_t a = static_cast<uint32_t>(rng()) % r;
+    const uint32_t b = static_cast<uint32_t>(rng()) % r;
+    switch (rng() % 7) {
+      case 0: result.emplace_back(load{a, static_cast<uint32_t>(rng())}); break;
+      case 1: result.emplace_back(add{a, b}); break;
+      case 2: result.emplace_back(sub{a, b}); break;
+      case 3: result.emplace_back(mul{a, b | 1}); break;
+      case 4: result.emplace_back(bxor{a, b}); break;
+      case 5: result.emplace_back(shr{a, b}); break;
+      default: result.emplace_back(skip_if_odd{a}); break;
+    }
+  }
+  const int32_t here = static_cast<int32_t>(result.size());
+  result.emplace_back(dec_jnz{r, loop_start - here});
+  return result;
+}
+
+// Counts the instructions executed, without instrumenting the machine
+struct counting_machine {
+  machine & m;
+  uint64_t count;
+
+  template <typename T>
+  int operator()(const T & t) {
+    ++count;
+    return m(t);
+  }
+};
+
+} // end namespace vm
+
+int
+main() {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  const std::vector<vm::instruction> program = vm::make_program(rng_seed);
+
+  // Count the instructions executed, in a separate run
+  uint64_t num_instructions = 0;
+  {
+    vm::machine m{};
+    vm::counting_machine cm{m, 0};
+    strict_variant::interpret(cm, program.begin(), program.end());
+    num_instructions = cm.count;
+  }
+
+#ifdef INTERPRETER_LOOP
+  const char * name = "strict_variant interpreter (apply_visitor loop)";
+#else
+  const char * name = "strict_variant interpreter (threaded)";
+#endif
+
+  std::fprintf(stdout, "%s:\n  num_variants = %u\n  program_length = %u\n  instructions = %llu\n\n",
+               name, static_cast<unsigned>(
+                       strict_variant::detail::variant_num_types<vm::instruction>::value),
+               program_length, static_cast<unsigned long long>(num_instructions));
+
+  vm::machine m{};
+  benchmark::DoNotOptimize(m);
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+#ifdef INTERPRETER_LOOP
+  std::ptrdiff_t pc = 0;
+  const std::ptrdiff_t n = static_cast<std::ptrdiff_t>(program.size());
+  while (0 <= pc && pc < n) {
+    pc += strict_variant::apply_visitor(m, program[static_cast<std::size_t>(pc)]);
+  }
+#else
+  strict_variant::interpret(m, program.begin(), program.end());
+#endif
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  benchmark::DoNotOptimize(m);
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per visit: %f\n",
+               (static_cast<double>(us) / static_cast<double>(num_instructions)) * 1000);
+  std::fprintf(stdout, "million instructions per second = %f\n\n\n",
+               static_cast<double>(num_instructions) / static_cast<double>(us));
+}
@@ -0,0 +1,147 @@
+// Benchmark of move assignment between variants whose types are `blank` and
+// `recursive_wrapper`s, counting heap allocations.
+//
+// Pairs of variants are swapped through a temporary, with two move
+// assignments. By default, whole variants are move assigned, which moves the
+// wrapper by taking its pointer, and leaves `blank` in the source. With
+// -DVALUE_ASSIGN, the (pierced) value is move assigned instead, which has to
+// make a new wrapper whenever the type changes, for comparison.
+
+#include "bench_api.hpp"
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+/***
+ * Count the heap allocations
+ */
+
+static uint64_t num_allocations{0};
+
+void *
+operator new(std::size_t size) {
+  ++num_allocations;
+  if (void * result = std::malloc(size ? size : 1)) { return result; }
+  throw std::bad_alloc{};
+}
+
+void
+operator delete(void * ptr) noexcept {
+  std::free(ptr);
+}
+
+void
+operator delete(void * ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+struct small_node {
+  uint32_t a, b;
+};
+
+struct medium_node {
+  uint64_t values[4];
+};
+
+struct large_node {
+  uint64_t values[16];
+};
+
+using var_t = strict_variant::variant<strict_variant::blank,
+                                      strict_variant::recursive_wrapper<small_node>,
+                                      strict_variant::recursive_wrapper<medium_node>,
+                                      strict_variant::recursive_wrapper<large_node>>;
+
+std::vector<var_t>
+make_sequence(std::mt19937 & rng) {
+  std::vector<var_t> result;
+  result.reserve(seq_length);
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    const uint32_t x = static_cast<uint32_t>(rng());
+    switch (x % 3) {
+      case 0: result.emplace_back(small_node{x, x >> 3}); break;
+      case 1: result.emplace_back(medium_node{{x, x, x, x}}); break;
+      default: result.emplace_back(large_node{{x}}); break;
+    }
+  }
+  return result;
+}
+
+#ifdef VALUE_ASSIGN
+struct value_assigner {
+  var_t & target;
+
+  template <typename T>
+  void operator()(T & t) const {
+    target = std::move(t);
+  }
+};
+#endif
+
+int
+main() {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  std::mt19937 rng{rng_seed};
+  std::vector<var_t> sequence = make_sequence(rng);
+
+  std::vector<uint32_t> sources;
+  sources.reserve(seq_length);
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    sources.push_back(static_cast<uint32_t>(rng()) % seq_length);
+  }
+
+#ifdef VALUE_ASSIGN
+  const char * name = "strict_variant move assign (value)";
+#else
+  const char * name = "strict_variant move assign";
+#endif
+
+  std::fprintf(stdout, "%s:\n  seq_length = %u\n  repeat_num = %u\n  sizeof = %u\n\n", name,
+               seq_length, repeat_num, static_cast<unsigned>(sizeof(var_t)));
+
+  const uint64_t allocations_before = num_allocations;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    for (uint32_t i = 0; i < seq_length; ++i) {
+      var_t & a = sequence[i];
+      var_t & b = sequence[sources[i]];
+      if (&a == &b) { continue; }
+      var_t tmp{std::move(a)};
+#ifdef VALUE_ASSIGN
+      strict_variant::apply_visitor(value_assigner{a}, b);
+      strict_variant::apply_visitor(value_assigner{b}, tmp);
+#else
+      a = std::move(b);
+      b = std::move(tmp);
+#endif
+    }
+    benchmark::ClobberMemory();
+  }
+
+  auto const end = clock_t::now();
+
+  const uint64_t allocations = num_allocations - allocations_before;
+  const double num_assignments = 2.0 * seq_length * repeat_num;
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "allocations = %llu\n", static_cast<unsigned long long>(allocations));
+  std::fprintf(stdout, "allocations per assignment: %f\n",
+               static_cast<double>(allocations) / num_assignments);
+  std::fprintf(stdout, "average nanoseconds per assignment: %f\n\n\n",
+               (static_cast<double>(us) / num_assignments) * 1000);
+}
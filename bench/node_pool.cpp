@@ -0,0 +1,126 @@
+// Multi-threaded benchmark of the allocations of `alloc_variant` nodes.
+//
+// Each thread repeatedly fills a sequence of variants whose types have throwing
+// moves, so that each one is in an `alloc_wrapper`, and then clears it. This
+// is run with 1, 2, 4, ... threads, up to the number of hardware threads, and
+// the total throughput is reported.
+//
+// By default, the nodes use `std::allocator`. With -DPOOL, they use
+// `strict_variant::pool_allocator`.
+
+#include "bench_api.hpp"
+#include <strict_variant/alloc_variant.hpp>
+#include <strict_variant/pool_allocator.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM / 10};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+// Three node sizes, all with throwing moves
+
+template <std::size_t N>
+struct node {
+  uint64_t values[N];
+
+  explicit node(uint64_t x) {
+    for (auto & v : values) {
+      v = x;
+    }
+  }
+  node(const node &) = default;
+  node(node && other) noexcept(false)
+    : node(static_cast<const node &>(other)) {}
+  node & operator=(const node &) = default;
+};
+
+#ifdef POOL
+using var_t =
+  strict_variant::alloc_variant<strict_variant::pool_allocator>::type<node<3>, node<8>, node<20>>;
+#else
+using var_t =
+  strict_variant::alloc_variant<std::allocator>::type<node<3>, node<8>, node<20>>;
+#endif
+
+static_assert(sizeof(var_t) <= 2 * sizeof(void *), "the nodes should be on the heap");
+
+void
+run_thread(const std::vector<uint32_t> & choices) {
+  std::vector<var_t> sequence;
+  sequence.reserve(seq_length);
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    for (uint32_t x : choices) {
+      switch (x % 3) {
+        case 0: sequence.emplace_back(node<3>{x}); break;
+        case 1: sequence.emplace_back(node<8>{x}); break;
+        default: sequence.emplace_back(node<20>{x}); break;
+      }
+    }
+    benchmark::ClobberMemory();
+    sequence.clear();
+  }
+}
+
+int
+main() {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  std::mt19937 rng{rng_seed};
+  std::vector<uint32_t> choices;
+  choices.reserve(seq_length);
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    choices.push_back(static_cast<uint32_t>(rng()));
+  }
+
+#ifdef POOL
+  const char * name = "strict_variant node allocation (pool_allocator)";
+#else
+  const char * name = "strict_variant node allocation (std::allocator)";
+#endif
+
+  unsigned max_threads = std::thread::hardware_concurrency();
+  if (!max_threads) { max_threads = 1; }
+
+  std::fprintf(stdout, "%s:\n  seq_length = %u\n  repeat_num = %u\n  max_threads = %u\n\n", name,
+               seq_length, repeat_num, max_threads);
+
+  for (unsigned num_threads = 1;; num_threads *= 2) {
+    if (num_threads > max_threads) { num_threads = max_threads; }
+
+    auto const start = clock_t::now();
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < num_threads; ++i) {
+      threads.emplace_back(run_thread, std::cref(choices));
+    }
+    for (auto & t : threads) {
+      t.join();
+    }
+
+    auto const end = clock_t::now();
+
+    const double num_allocations = static_cast<double>(seq_length) * repeat_num * num_threads;
+    unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    std::fprintf(stdout, "threads = %u: took %lu microseconds, %f million allocations per second\n",
+                 num_threads, us, num_allocations / static_cast<double>(us));
+
+    if (num_threads == max_threads) { break; }
+  }
+
+#ifdef POOL
+  const strict_variant::node_pool_stats stats = strict_variant::pool_allocator_stats();
+  std::fprintf(stdout, "\npool: allocations = %llu, slabs = %llu\n",
+               static_cast<unsigned long long>(stats.allocations),
+               static_cast<unsigned long long>(stats.slabs));
+#endif
+
+  std::fprintf(stdout, "\n\n");
+}
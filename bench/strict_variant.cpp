@@ -1,4 +1,5 @@
 #include "bench_framework.hpp"
+#include <strict_variant/range_visit.hpp>
 #include <strict_variant/variant.hpp>
 
 static constexpr uint32_t num_variants{NUM_VARIANTS};
@@ -6,15 +7,100 @@ static constexpr uint32_t seq_length{SEQ_LENGTH};
 static constexpr uint32_t repeat_num{REPEAT_NUM};
 static constexpr uint32_t rng_seed{RNG_SEED};
 
+// For comparison, the jumptable policy as it was before the table became a
+// constexpr member: a function-local static array in the dispatcher. It is
+// initialized with the addresses of functions, so it is constant-initialized
+// too, and there is no guard to check on each call. These executables check
+// that the constexpr table is no slower. (The pointers take forwarding
+// references, as `visitor_caller` does now.)
+namespace strict_variant {
+namespace dispatch {
+
+struct local_jumptable {
+  template <typename return_t, typename Internal, typename ulist>
+  struct dispatcher;
+
+  template <typename return_t, typename Internal, unsigned... Indices>
+  struct dispatcher<return_t, Internal, mpl::ulist<Indices...>> {
+    template <typename Storage, typename Visitor>
+    return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+      using whichCaller = return_t (*)(Storage &&, Visitor &&);
+
+      static whichCaller callers[sizeof...(Indices)] = {
+        &detail::visitor_caller<Indices, Internal, Storage, Visitor>...};
+
+      return (*callers[which])(std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+    }
+  };
+
+  template <typename return_t, typename Internal, unsigned num_types>
+  using dispatcher_t = dispatcher<return_t, Internal, mpl::count_t<num_types>>;
+};
+
+// Name for use on the command line, e.g. -DDISPATCH_POLICY=branchless_default
+using branchless_default = branchless<>;
+
+} // end namespace dispatch
+
+// The benchmark visitor ignores the value, so it is safe on any bytes
+template <>
+struct branchless_safe<benchmark::visitor> : std::true_type {};
+
+} // end namespace strict_variant
+
+// Optionally, override the dispatch policy, e.g. -DDISPATCH_POLICY=jumptable
+#ifdef DISPATCH_POLICY
+namespace strict_variant {
+template <typename First, typename... Types>
+struct dispatch_policy<variant<First, Types...>> {
+  using type = dispatch::DISPATCH_POLICY;
+};
+} // end namespace strict_variant
+
+#define STRINGIFY_IMPL(X) #X
+#define STRINGIFY(X) STRINGIFY_IMPL(X)
+#define VARIANT_NAME "strict_variant::variant (" STRINGIFY(DISPATCH_POLICY) ")"
+#elif defined(HINT_HOT_TYPES)
+#define VARIANT_NAME "strict_variant::variant (likely 0, 1)"
+#elif defined(RANGE_VISIT)
+#define VARIANT_NAME "strict_variant::variant (apply_visitor_range)"
+#else
+#define VARIANT_NAME "strict_variant::variant"
+#endif
+
 struct visitor_applier {
   template <typename T>
   uint32_t operator()(T && t) const {
+#ifdef HINT_HOT_TYPES
+    // Tell the dispatcher, at this call site, that types 0 and 1 are the common ones
+    using policy_t =
+      strict_variant::dispatch::likely<strict_variant::dispatch::default_policy, 0, 1>;
+    return strict_variant::apply_visitor_with<policy_t>(benchmark::visitor{}, std::forward<T>(t));
+#else
     return strict_variant::apply_visitor(benchmark::visitor{}, std::forward<T>(t));
+#endif
+  }
+
+  // Accumulates the results of visiting a range
+  struct summing_visitor {
+    uint32_t sum;
+
+    template <typename T>
+    void operator()(const T & t) {
+      sum += benchmark::visitor{}(t);
+    }
+  };
+
+  template <typename It>
+  uint32_t operator()(It first, It last) const {
+    summing_visitor vis{0};
+    strict_variant::apply_visitor_range(vis, first, last);
+    return vis.sum;
   }
 };
 
 int
 main() {
   benchmark::run_benchmark<strict_variant::variant, num_variants, seq_length, repeat_num,
-                           visitor_applier>("strict_variant::variant", rng_seed);
+                           visitor_applier>(VARIANT_NAME, rng_seed);
 }
@@ -0,0 +1,99 @@
+// Benchmark of destroying long lists of `recursive_wrapper` nodes.
+//
+// The lists are built by emplacing each node into the tail of the one before,
+// so that building them doesn't recurse. First `repeat_num` lists of
+// `seq_length` nodes are built and destroyed, then one list of
+// `seq_length * repeat_num` nodes.
+//
+// By default, each node is destroyed by the one before it, recursively, and
+// the long list is skipped, since it would overflow the stack. With
+// -DITERATIVE, the nodes opt in to `iterative_destruction`.
+
+#include "bench_api.hpp"
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+
+struct node;
+
+using list = strict_variant::variant<uint32_t, strict_variant::recursive_wrapper<node>>;
+
+struct node {
+  uint32_t value;
+  list next;
+
+  explicit node(uint32_t v)
+    : value(v)
+    , next(0u) {}
+};
+
+#ifdef ITERATIVE
+namespace strict_variant {
+template <>
+struct iterative_destruction<node> : std::true_type {};
+} // end namespace strict_variant
+#endif
+
+void
+build(list & head, uint32_t n) {
+  list * tail = &head;
+  for (uint32_t i = 0; i < n; ++i) {
+    tail->emplace<node>(i);
+    tail = &strict_variant::get<node>(tail)->next;
+  }
+}
+
+// Returns the number of microseconds taken to destroy the lists
+unsigned long
+run(uint32_t length, uint32_t count) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  clock_t::duration total{0};
+  for (; count; --count) {
+    list * head = new list{0u};
+    build(*head, length);
+    benchmark::ClobberMemory();
+
+    auto const start = clock_t::now();
+    delete head;
+    benchmark::ClobberMemory();
+    total += clock_t::now() - start;
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(total).count();
+}
+
+void
+report(const char * label, uint32_t length, uint32_t count, unsigned long us) {
+  const double num_nodes = static_cast<double>(length) * count;
+  std::fprintf(stdout, "%s: took %lu microseconds\n", label, us);
+  std::fprintf(stdout, "  average nanoseconds per node: %f\n",
+               (static_cast<double>(us) / num_nodes) * 1000);
+}
+
+int
+main() {
+#ifdef ITERATIVE
+  const char * name = "strict_variant list destruction (iterative)";
+#else
+  const char * name = "strict_variant list destruction (recursive)";
+#endif
+
+  std::fprintf(stdout, "%s:\n  seq_length = %u\n  repeat_num = %u\n\n", name, seq_length,
+               repeat_num);
+
+  report("short lists", seq_length, repeat_num, run(seq_length, repeat_num));
+
+#ifdef ITERATIVE
+  report("one long list", seq_length * repeat_num, 1, run(seq_length * repeat_num, 1));
+#else
+  std::fprintf(stdout, "one long list: skipped\n");
+#endif
+
+  std::fprintf(stdout, "\n\n");
+}
@@ -8,7 +8,13 @@
 /***
  * For use with strict_variant::variant
  */
+#include <strict_variant/config.hpp>
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/relocate.hpp>
 #include <strict_variant/wrapper.hpp>
+#include <cstddef>
+#include <memory>
+#include <new>
 #include <type_traits>
 #include <utility>
 
@@ -30,18 +36,85 @@
 
 #endif // STRICT_VARIANT_DEBUG
 
-//[ strict_variant_alloc_wrapper
 namespace strict_variant {
 
+namespace detail {
+
+#ifdef STRICT_VARIANT_CXX14
+template <typename T>
+struct is_final_class : std::is_final<T> {};
+#else
+template <typename T>
+struct is_final_class : std::integral_constant<bool, __is_final(T)> {};
+#endif
+
+/***
+ * Holds the allocator of an alloc_wrapper. An empty allocator is held as a
+ * base class, so that with a stateless allocator the wrapper is only the size
+ * of a pointer.
+ */
+template <typename Alloc, bool ebo = std::is_empty<Alloc>::value && !is_final_class<Alloc>::value>
+class alloc_holder : private Alloc {
+protected:
+  alloc_holder() = default;
+
+  explicit alloc_holder(const Alloc & a) noexcept
+    : Alloc(a) {}
+
+  explicit alloc_holder(Alloc && a) noexcept
+    : Alloc(std::move(a)) {}
+
+  Alloc & get_alloc() noexcept { return *this; }
+  const Alloc & get_alloc() const noexcept { return *this; }
+};
+
+template <typename Alloc>
+class alloc_holder<Alloc, false> {
+  Alloc m_alloc;
+
+protected:
+  alloc_holder() = default;
+
+  explicit alloc_holder(const Alloc & a) noexcept
+    : m_alloc(a) {}
+
+  explicit alloc_holder(Alloc && a) noexcept
+    : m_alloc(std::move(a)) {}
+
+  Alloc & get_alloc() noexcept { return m_alloc; }
+  const Alloc & get_alloc() const noexcept { return m_alloc; }
+};
+
+} // end namespace detail
+
+//[ strict_variant_alloc_wrapper
+/***
+ * Like `recursive_wrapper`, but allocates with `Alloc`.
+ *
+ * The allocator is stored in the wrapper, and is used to deallocate it.
+ * When a wrapper is constructed from a value, the allocator is default
+ * constructed. To use a particular allocator, construct the wrapper (or
+ * `emplace` it in a variant) with `std::allocator_arg, alloc, args...`.
+ * A copy gets its allocator from `select_on_container_copy_construction`,
+ * and a move takes the allocator along with the pointer.
+ */
 template <typename T, typename Alloc>
-class alloc_wrapper {
+class alloc_wrapper
+  : private detail::alloc_holder<
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>> {
+public:
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<T> allocator_type;
+
+private:
+  using traits_t = std::allocator_traits<allocator_type>;
+  using holder_t = detail::alloc_holder<allocator_type>;
+
   T * m_t;
 
   void destroy() {
     if (m_t) {
-      Alloc a;
       m_t->~T();
-      a.deallocate(m_t, 1);
+      traits_t::deallocate(this->get_alloc(), m_t, 1);
     }
   }
 
@@ -50,19 +123,19 @@ class alloc_wrapper {
   // if initialization was unsuccessful.
 
   struct initer {
-    Alloc a;
+    allocator_type & a;
     bool success;
     T * m_t;
 
-    initer()
-      : a()
+    explicit initer(allocator_type & _a)
+      : a(_a)
       , success(false)
       , m_t(nullptr) {
-      m_t = a.allocate(1);
+      m_t = traits_t::allocate(a, 1);
     }
 
     ~initer() {
-      if (!success) { a.deallocate(m_t, 1); }
+      if (!success) { traits_t::deallocate(a, m_t, 1); }
     }
 
     template <typename... Args>
@@ -74,7 +147,7 @@ class alloc_wrapper {
 
   template <typename... Args>
   void init(Args &&... args) {
-    initer i;
+    initer i{this->get_alloc()};
     i.go(std::forward<Args>(args)...);
     m_t = i.m_t;
   }
@@ -84,9 +157,19 @@ public:
 
   ~alloc_wrapper() noexcept { this->destroy(); }
 
-  template <typename... Args>
+  template <typename... Args,
+            typename = mpl::enable_if_t<!detail::leading_allocator_arg<Args...>::value>>
   alloc_wrapper(Args &&... args)
-    : m_t(nullptr) {
+    : holder_t()
+    , m_t(nullptr) {
+    this->init(std::forward<Args>(args)...);
+  }
+
+  // Construct using a particular allocator
+  template <typename... Args>
+  alloc_wrapper(std::allocator_arg_t, const allocator_type & a, Args &&... args)
+    : holder_t(a)
+    , m_t(nullptr) {
     this->init(std::forward<Args>(args)...);
   }
 
@@ -94,13 +177,15 @@ public:
     : alloc_wrapper(static_cast<const alloc_wrapper &>(rhs)) {}
 
   alloc_wrapper(const alloc_wrapper & rhs)
-    : m_t(nullptr) {
+    : holder_t(traits_t::select_on_container_copy_construction(rhs.get_alloc()))
+    , m_t(nullptr) {
     this->init(rhs.get());
   }
 
-  // Pointer move
+  // Pointer move, the allocator goes with the pointer
   alloc_wrapper(alloc_wrapper && rhs) noexcept //
-    : m_t(rhs.m_t)                             //
+    : holder_t(std::move(rhs.get_alloc())),    //
+      m_t(rhs.m_t)                             //
   {
     rhs.m_t = nullptr;
   }
@@ -110,6 +195,8 @@ public:
   alloc_wrapper & operator=(const alloc_wrapper &) = delete;
   alloc_wrapper & operator=(alloc_wrapper &&) = delete;
 
+  allocator_type get_allocator() const noexcept { return this->get_alloc(); }
+
   T & get() & {
     STRICT_VARIANT_ASSERT(m_t, "Bad access!");
     return *m_t;
@@ -125,11 +212,27 @@ public:
 };
 //]
 
+// A pointer to the heap and the allocator, so it can be moved by copying the
+// bytes if the allocator can
+template <typename T, typename A>
+struct is_trivially_relocatable<alloc_wrapper<T, A>>
+  : std::integral_constant<bool, std::is_empty<A>::value || is_trivially_relocatable<A>::value> {
+};
+
 namespace detail {
 
 template <typename T, typename A>
 struct is_wrapper<alloc_wrapper<T, A>> : std::true_type {};
 
+// The new wrapper uses the same allocator
+template <typename T, typename A>
+struct wrapper_value_mover<alloc_wrapper<T, A>> {
+  template <std::size_t index, typename Storage>
+  static void move_value(Storage & storage, alloc_wrapper<T, A> & w) {
+    storage.template initialize<index>(std::allocator_arg, w.get_allocator(), std::move(w).get());
+  }
+};
+
 } // end namespace detail
 
 } // end namespace strict_variant
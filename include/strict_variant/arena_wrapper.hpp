@@ -0,0 +1,313 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * For use with strict_variant::variant
+ *
+ * `arena_wrapper<T>` is like `recursive_wrapper<T>`, except that the value is
+ * bump-allocated from a `monotonic_arena`, instead of with `new`. The wrapper
+ * never frees anything, and its destructor is trivial -- all the values are
+ * freed together when the arena is released.
+ *
+ * So a tree of variants built with `arena_wrapper` is torn down without
+ * visiting any nodes. Values which are not trivially destructible are
+ * registered with the arena when they are created, and destroyed when it is
+ * released.
+ */
+
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/relocate.hpp>
+#include <strict_variant/wrapper.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// #define STRICT_VARIANT_DEBUG
+
+#ifdef STRICT_VARIANT_DEBUG
+#include <cassert>
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+    assert((X) && C);                                                                              \
+  } while (0)
+
+#else // STRICT_VARIANT_DEBUG
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif // STRICT_VARIANT_DEBUG
+
+namespace strict_variant {
+
+//[ strict_variant_monotonic_arena
+/***
+ * A region of memory which is handed out by bumping a pointer, and freed all
+ * at once by `release`. Memory is obtained in chunks from `operator new`.
+ */
+class monotonic_arena {
+  struct chunk {
+    chunk * next;
+    std::size_t size;
+  };
+
+  struct finalizer {
+    finalizer * next;
+    void (*destroy)(void *);
+    void * object;
+  };
+
+  chunk * m_chunks;
+  char * m_pos;
+  char * m_end;
+  finalizer * m_finalizers;
+  std::size_t m_chunk_size;
+
+  static char * chunk_begin(chunk * c) noexcept { return reinterpret_cast<char *>(c + 1); }
+
+  void * allocate_slow(std::size_t size, std::size_t align) {
+    const std::size_t needed = size + align;
+    const std::size_t chunk_size = needed > m_chunk_size ? needed : m_chunk_size;
+    chunk * c = static_cast<chunk *>(::operator new(sizeof(chunk) + chunk_size));
+    c->next = m_chunks;
+    c->size = chunk_size;
+    m_chunks = c;
+    m_pos = chunk_begin(c);
+    m_end = m_pos + chunk_size;
+    return this->allocate(size, align);
+  }
+
+  template <typename T>
+  static void destroy_object(void * p) noexcept {
+    static_cast<T *>(p)->~T();
+  }
+
+  template <typename T, typename... Args>
+  T * create_impl(std::true_type, Args &&... args) {
+    void * p = this->allocate(sizeof(T), alignof(T));
+    return new (p) T(std::forward<Args>(args)...);
+  }
+
+  // Reserve the finalizer first, so that it can't fail after T is constructed
+  template <typename T, typename... Args>
+  T * create_impl(std::false_type, Args &&... args) {
+    finalizer * f = static_cast<finalizer *>(this->allocate(sizeof(finalizer), alignof(finalizer)));
+    void * p = this->allocate(sizeof(T), alignof(T));
+    T * result = new (p) T(std::forward<Args>(args)...);
+    f->next = m_finalizers;
+    f->destroy = &monotonic_arena::destroy_object<T>;
+    f->object = result;
+    m_finalizers = f;
+    return result;
+  }
+
+  void run_finalizers() noexcept {
+    while (m_finalizers) {
+      finalizer * f = m_finalizers;
+      m_finalizers = f->next;
+      f->destroy(f->object);
+    }
+  }
+
+public:
+  static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+  explicit monotonic_arena(std::size_t chunk_size = default_chunk_size) noexcept
+    : m_chunks(nullptr)
+    , m_pos(nullptr)
+    , m_end(nullptr)
+    , m_finalizers(nullptr)
+    , m_chunk_size(chunk_size) {}
+
+  monotonic_arena(const monotonic_arena &) = delete;
+  monotonic_arena & operator=(const monotonic_arena &) = delete;
+
+  ~monotonic_arena() noexcept {
+    this->release();
+    if (m_chunks) { ::operator delete(m_chunks); }
+  }
+
+  // Align must be a power of two
+  void * allocate(std::size_t size, std::size_t align) {
+    const std::uintptr_t pos = reinterpret_cast<std::uintptr_t>(m_pos);
+    const std::uintptr_t result = (pos + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+    if (result + size > reinterpret_cast<std::uintptr_t>(m_end)) {
+      return this->allocate_slow(size, align);
+    }
+    m_pos = reinterpret_cast<char *>(result + size);
+    return reinterpret_cast<void *>(result);
+  }
+
+  // Construct a T in the arena. If T is not trivially destructible, it is
+  // destroyed when the arena is released.
+  template <typename T, typename... Args>
+  T * create(Args &&... args) {
+    return this->create_impl<T>(std::is_trivially_destructible<T>{},
+                                std::forward<Args>(args)...);
+  }
+
+  // Destroy the registered objects, newest first, and free all the memory.
+  // The most recent chunk is kept, to be reused.
+  void release() noexcept {
+    this->run_finalizers();
+    if (m_chunks) {
+      chunk * c = m_chunks->next;
+      while (c) {
+        chunk * next = c->next;
+        ::operator delete(c);
+        c = next;
+      }
+      m_chunks->next = nullptr;
+      m_pos = chunk_begin(m_chunks);
+    }
+  }
+
+  // Number of bytes handed out from the current chunk
+  std::size_t used() const noexcept {
+    return m_chunks ? static_cast<std::size_t>(m_pos - chunk_begin(m_chunks)) : 0;
+  }
+};
+//]
+
+//[ strict_variant_arena_scope
+/***
+ * Makes an arena current in this thread, for the lifetime of the scope.
+ * Scopes may be nested.
+ */
+class arena_scope {
+  monotonic_arena * m_prev;
+
+public:
+  explicit arena_scope(monotonic_arena & a) noexcept : m_prev(current()) { current() = &a; }
+  ~arena_scope() noexcept { current() = m_prev; }
+
+  arena_scope(const arena_scope &) = delete;
+  arena_scope & operator=(const arena_scope &) = delete;
+
+  static monotonic_arena *& current() noexcept {
+    static thread_local monotonic_arena * instance = nullptr;
+    return instance;
+  }
+};
+//]
+
+//[ strict_variant_arena_wrapper
+template <typename T>
+class arena_wrapper {
+  // The node records its arena, so that copies and moves of the wrapper can go
+  // in the same arena, even when no `arena_scope` is active.
+  struct node {
+    monotonic_arena * arena;
+    T value;
+
+    template <typename... Args>
+    explicit node(monotonic_arena & a, Args &&... args)
+      : arena(&a)
+      , value(std::forward<Args>(args)...) {}
+  };
+
+  node * m_t;
+
+  template <typename... Args>
+  void init(monotonic_arena & a, Args &&... args) {
+    m_t = a.template create<node>(a, std::forward<Args>(args)...);
+  }
+
+  static monotonic_arena & current_arena() noexcept {
+    STRICT_VARIANT_ASSERT(arena_scope::current(), "No arena_scope is active!");
+    return *arena_scope::current();
+  }
+
+public:
+  typedef T value_type;
+
+  // Trivial: the value is destroyed when the arena is released
+  ~arena_wrapper() = default;
+
+  // Allocates in the current arena, see `arena_scope`
+  template <typename... Args,
+            typename = mpl::enable_if_t<!detail::leading_allocator_arg<Args...>::value>>
+  arena_wrapper(Args &&... args)
+    : m_t(nullptr) {
+    this->init(current_arena(), std::forward<Args>(args)...);
+  }
+
+  // Allocates in a particular arena
+  template <typename... Args>
+  arena_wrapper(std::allocator_arg_t, monotonic_arena & a, Args &&... args)
+    : m_t(nullptr) {
+    this->init(a, std::forward<Args>(args)...);
+  }
+
+  arena_wrapper(arena_wrapper & rhs)
+    : arena_wrapper(static_cast<const arena_wrapper &>(rhs)) {}
+
+  // Copies into the arena of `rhs`
+  arena_wrapper(const arena_wrapper & rhs)
+    : m_t(nullptr) {
+    this->init(rhs.get_arena(), rhs.get());
+  }
+
+  // Pointer move
+  arena_wrapper(arena_wrapper && rhs) noexcept //
+    : m_t(rhs.m_t)                             //
+  {
+    rhs.m_t = nullptr;
+  }
+
+  arena_wrapper & operator=(const arena_wrapper &) = delete;
+  arena_wrapper & operator=(arena_wrapper &&) = delete;
+
+  T & get() & {
+    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
+    return m_t->value;
+  }
+  const T & get() const & {
+    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
+    return m_t->value;
+  }
+  T && get() && {
+    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
+    return std::move(m_t->value);
+  }
+
+  // The arena which holds the value
+  monotonic_arena & get_arena() const noexcept {
+    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
+    return *m_t->arena;
+  }
+};
+//]
+
+// Just a pointer into the arena, so it can be moved by copying the bytes
+template <typename T>
+struct is_trivially_relocatable<arena_wrapper<T>> : std::true_type {};
+
+namespace detail {
+
+template <typename T>
+struct is_wrapper<arena_wrapper<T>> : std::true_type {};
+
+// The new wrapper goes in the same arena
+template <typename T>
+struct wrapper_value_mover<arena_wrapper<T>> {
+  template <std::size_t index, typename Storage>
+  static void move_value(Storage & storage, arena_wrapper<T> & w) {
+    storage.template initialize<index>(std::allocator_arg, w.get_arena(), std::move(w).get());
+  }
+};
+
+} // end namespace detail
+
+} // end namespace strict_variant
+
+#undef STRICT_VARIANT_ASSERT
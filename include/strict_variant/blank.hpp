@@ -0,0 +1,50 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/***
+ * Designated empty alternative, similar to `boost::blank`.
+ *
+ * If a variant has `blank` as one of its types, then moving from the variant
+ * while it holds a `recursive_wrapper` steals the pointer, and leaves the
+ * moved-from variant holding `blank`. So the move constructor doesn't allocate
+ * and is `noexcept`.
+ */
+
+//[ strict_variant_blank
+namespace strict_variant {
+
+struct blank {};
+
+constexpr bool
+operator==(blank, blank) noexcept {
+  return true;
+}
+
+constexpr bool
+operator!=(blank, blank) noexcept {
+  return false;
+}
+
+constexpr bool
+operator<(blank, blank) noexcept {
+  return false;
+}
+
+} // end namespace strict_variant
+//]
+
+namespace std {
+
+template <>
+struct hash<strict_variant::blank> {
+  std::size_t operator()(strict_variant::blank) const noexcept { return 0; }
+};
+
+} // end namespace std
@@ -0,0 +1,30 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Language feature detection.
+ *
+ * `STRICT_VARIANT_CONSTEXPR14` marks functions which can only be `constexpr`
+ * with the relaxed rules of C++14 (more than a single return statement, or
+ * calls to `std::forward`). At C++11 standard it expands to nothing.
+ */
+
+#if (__cplusplus >= 201402L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#define STRICT_VARIANT_CXX14
+#endif
+
+#ifdef STRICT_VARIANT_CXX14
+#define STRICT_VARIANT_CONSTEXPR14 constexpr
+#else
+#define STRICT_VARIANT_CONSTEXPR14
+#endif
+
+// #define STRICT_VARIANT_UNION_STORAGE
+
+#if defined(STRICT_VARIANT_UNION_STORAGE) && !defined(STRICT_VARIANT_CXX14)
+#error "STRICT_VARIANT_UNION_STORAGE requires C++14 or later"
+#endif
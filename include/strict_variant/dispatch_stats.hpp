@@ -0,0 +1,225 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Dispatch instrumentation.
+ *
+ * When `STRICT_VARIANT_DISPATCH_STATS` is defined, every visitation of a
+ * variant is counted, per variant type and per alternative. This is meant to
+ * help choose a dispatch policy, and find the hot types.
+ *
+ * The internal visits used to copy, move or destroy a variant, or to change
+ * its type, are not counted.
+ *
+ * The counts are kept in plain thread-local counters, which are added into
+ * shared atomic counters (with relaxed ordering) when the thread exits, or
+ * when `flush_dispatch_stats()` is called. At program exit, the totals are
+ * printed to `stderr`. `print_dispatch_stats()` may also be called directly.
+ *
+ * When the macro is not defined, this header defines nothing, and the
+ * dispatch code contains no trace of it.
+ */
+
+#ifdef STRICT_VARIANT_DISPATCH_STATS
+
+#include <strict_variant/variant_storage.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace strict_variant {
+
+namespace detail {
+
+// Get a readable name for a type, without relying on RTTI
+template <typename T>
+std::string
+stats_type_name() {
+#if defined(__clang__) || defined(__GNUC__)
+  std::string result{__PRETTY_FUNCTION__};
+  const auto start = result.find("T = ");
+  if (start == std::string::npos) { return result; }
+  result = result.substr(start + 4);
+  const auto end = result.find_first_of(";]");
+  return result.substr(0, end);
+#elif defined(_MSC_VER)
+  std::string result{__FUNCSIG__};
+  const auto start = result.find("stats_type_name<");
+  if (start == std::string::npos) { return result; }
+  result = result.substr(start + 16);
+  return result.substr(0, result.rfind(">("));
+#else
+  return "?";
+#endif
+}
+
+// Shared counters for one variant type
+struct stats_entry {
+  std::string name;
+  std::vector<std::string> type_names;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> counts;
+
+  explicit stats_entry(std::string n, std::vector<std::string> tn)
+    : name(std::move(n))
+    , type_names(std::move(tn))
+    , counts(new std::atomic<std::uint64_t>[type_names.size()]) {
+    for (std::size_t i = 0; i < type_names.size(); ++i) {
+      counts[i].store(0, std::memory_order_relaxed);
+    }
+  }
+};
+
+// Owns all of the shared counters, prints them when destroyed
+struct stats_registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<stats_entry>> entries;
+
+  stats_entry * add(std::string name, std::vector<std::string> type_names) {
+    std::lock_guard<std::mutex> lock{mutex};
+    entries.emplace_back(new stats_entry{std::move(name), std::move(type_names)});
+    return entries.back().get();
+  }
+
+  void print(std::FILE * out) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (entries.empty()) { return; }
+    std::fprintf(out, "strict_variant dispatch stats\n");
+    for (const auto & e : entries) {
+      std::uint64_t total = 0;
+      for (std::size_t i = 0; i < e->type_names.size(); ++i) {
+        total += e->counts[i].load(std::memory_order_relaxed);
+      }
+      std::fprintf(out, "  %s : %llu visits\n", e->name.c_str(),
+                   static_cast<unsigned long long>(total));
+      for (std::size_t i = 0; i < e->type_names.size(); ++i) {
+        const std::uint64_t c = e->counts[i].load(std::memory_order_relaxed);
+        std::fprintf(out, "    [%u] %s = %llu (%.1f%%)\n", static_cast<unsigned>(i),
+                     e->type_names[i].c_str(), static_cast<unsigned long long>(c),
+                     total ? 100.0 * static_cast<double>(c) / static_cast<double>(total) : 0.0);
+      }
+    }
+  }
+
+  ~stats_registry() { this->print(stderr); }
+
+  static stats_registry & get() {
+    static stats_registry instance;
+    return instance;
+  }
+};
+
+// Shared counters for a particular storage type
+template <typename First, typename... Types>
+stats_entry *
+stats_entry_for() {
+  static stats_entry * const entry = [] {
+    std::vector<std::string> names{stats_type_name<First>(), stats_type_name<Types>()...};
+    std::string name{"variant<"};
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      if (i) { name += ", "; }
+      name += names[i];
+    }
+    name += ">";
+    return stats_registry::get().add(std::move(name), std::move(names));
+  }();
+  return entry;
+}
+
+// Registry of the thread-local counters of the current thread, so they can be
+// flushed on demand
+struct stats_local_base {
+  virtual void flush() noexcept = 0;
+
+  static std::vector<stats_local_base *> & thread_list() {
+    static thread_local std::vector<stats_local_base *> list;
+    return list;
+  }
+
+protected:
+  ~stats_local_base() = default;
+};
+
+// Thread-local counters for a particular storage type
+template <typename First, typename... Types>
+struct stats_local final : stats_local_base {
+  static constexpr std::size_t num_types = 1 + sizeof...(Types);
+
+  std::uint64_t counts[num_types];
+  stats_entry * entry;
+
+  stats_local()
+    : counts()
+    , entry(stats_entry_for<First, Types...>()) {
+    thread_list().push_back(this);
+  }
+
+  void flush() noexcept override {
+    for (std::size_t i = 0; i < num_types; ++i) {
+      if (counts[i]) {
+        entry->counts[i].fetch_add(counts[i], std::memory_order_relaxed);
+        counts[i] = 0;
+      }
+    }
+  }
+
+  ~stats_local() {
+    this->flush();
+    auto & list = thread_list();
+    for (auto & p : list) {
+      if (p == this) { p = nullptr; }
+    }
+  }
+
+  static stats_local & get() {
+    static thread_local stats_local instance;
+    return instance;
+  }
+};
+
+// Called by the dispatcher. Internal visits are not counted, and neither are
+// the dispatches over other kinds of storage (e.g. multivisitation).
+template <typename Internal, typename Storage>
+struct dispatch_stats {
+  static void record(unsigned) noexcept {}
+};
+
+template <typename First, typename... Types>
+struct dispatch_stats<false_, storage<First, Types...>> {
+  static void record(unsigned which) noexcept {
+    ++stats_local<First, Types...>::get().counts[which];
+  }
+};
+
+} // end namespace detail
+
+/***
+ * Add the dispatch counts of the current thread into the shared totals.
+ * (This happens automatically when a thread exits.)
+ */
+inline void
+flush_dispatch_stats() noexcept {
+  for (auto * p : detail::stats_local_base::thread_list()) {
+    if (p) { p->flush(); }
+  }
+}
+
+/***
+ * Print the shared totals. (This happens automatically at program exit.)
+ */
+inline void
+print_dispatch_stats(std::FILE * out = stderr) {
+  detail::stats_registry::get().print(out);
+}
+
+} // end namespace strict_variant
+
+#endif // STRICT_VARIANT_DISPATCH_STATS
@@ -0,0 +1,164 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Threaded interpreter over a sequence of instruction variants.
+ *
+ * A bytecode program is represented as a random-access range of variants,
+ * where each alternative is an instruction. The handler is a visitor which
+ * executes an instruction, and returns the offset to the next instruction to
+ * execute (1 to fall through to the next one, other values to jump).
+ * Execution stops when the program counter leaves the range.
+ *
+ * On GCC and clang, this uses "direct threading" with computed goto: each
+ * instruction's handler ends with its own indirect jump to the handler for
+ * the next instruction, rather than returning to one central dispatch. This
+ * gives the branch predictor one prediction site per instruction type, and
+ * usually makes the interpreter loop considerably faster.
+ *
+ * Elsewhere, or if `STRICT_VARIANT_NO_COMPUTED_GOTO` is defined, or if there
+ * are more than 64 instruction types, it falls back to a loop over
+ * `apply_visitor`.
+ */
+
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_dispatch.hpp>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+#if defined(__GNUC__) && !defined(STRICT_VARIANT_NO_COMPUTED_GOTO)
+#define STRICT_VARIANT_COMPUTED_GOTO
+#endif
+
+namespace strict_variant {
+
+namespace detail {
+
+// Portable version, loop over apply_visitor
+template <unsigned num_types, bool use_goto>
+struct interpreter_impl {
+  template <typename Handler, typename RandomIt>
+  static std::ptrdiff_t run(Handler & handler, RandomIt first, std::ptrdiff_t n,
+                            std::ptrdiff_t pc) {
+    while (0 <= pc && pc < n) {
+      pc += static_cast<std::ptrdiff_t>(apply_visitor(handler, first[pc]));
+    }
+    return pc;
+  }
+};
+
+#ifdef STRICT_VARIANT_COMPUTED_GOTO
+
+static constexpr unsigned interpreter_max_types = 64;
+
+// Threaded version. The 64 labels are generated by the preprocessor, those
+// which don't correspond to an instruction type are unreachable.
+template <unsigned num_types>
+struct interpreter_impl<num_types, true> {
+  static_assert(num_types <= interpreter_max_types, "Too many types for threaded interpreter");
+
+  template <unsigned K>
+  struct valid_index {
+    static constexpr bool valid = K < num_types;
+    static constexpr std::size_t value = valid ? K : 0;
+  };
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+#define STRICT_VARIANT_INTERPRETER_LABEL(A, B) &&label_##A##B,
+
+#define STRICT_VARIANT_INTERPRETER_LABELS_8(A)                                                     \
+  STRICT_VARIANT_INTERPRETER_LABEL(A, 0)                                                           \
+  STRICT_VARIANT_INTERPRETER_LABEL(A, 1)                                                           \
+  STRICT_VARIANT_INTERPRETER_LABEL(A, 2)                                                           \
+  STRICT_VARIANT_INTERPRETER_LABEL(A, 3)                                                           \
+  STRICT_VARIANT_INTERPRETER_LABEL(A, 4)                                                           \
+  STRICT_VARIANT_INTERPRETER_LABEL(A, 5)                                                           \
+  STRICT_VARIANT_INTERPRETER_LABEL(A, 6)                                                           \
+  STRICT_VARIANT_INTERPRETER_LABEL(A, 7)
+
+#define STRICT_VARIANT_INTERPRETER_CASE(A, B)                                                      \
+  label_##A##B : if (!valid_index<A * 8 + B>::valid) { __builtin_unreachable(); }                  \
+  pc += static_cast<std::ptrdiff_t>(                                                               \
+    handler(storage_access::get(first[pc]).template get_value<valid_index<A * 8 + B>::value>(      \
+      false_{})));                                                                                 \
+  if (pc < 0 || pc >= n) { return pc; }                                                            \
+  goto *table[first[pc].which()];
+
+#define STRICT_VARIANT_INTERPRETER_CASES_8(A)                                                      \
+  STRICT_VARIANT_INTERPRETER_CASE(A, 0)                                                            \
+  STRICT_VARIANT_INTERPRETER_CASE(A, 1)                                                            \
+  STRICT_VARIANT_INTERPRETER_CASE(A, 2)                                                            \
+  STRICT_VARIANT_INTERPRETER_CASE(A, 3)                                                            \
+  STRICT_VARIANT_INTERPRETER_CASE(A, 4)                                                            \
+  STRICT_VARIANT_INTERPRETER_CASE(A, 5)                                                            \
+  STRICT_VARIANT_INTERPRETER_CASE(A, 6)                                                            \
+  STRICT_VARIANT_INTERPRETER_CASE(A, 7)
+
+  template <typename Handler, typename RandomIt>
+  static std::ptrdiff_t run(Handler & handler, RandomIt first, std::ptrdiff_t n,
+                            std::ptrdiff_t pc) {
+    // Label addresses are constants, so this has no initialization guard
+    static void * const table[interpreter_max_types] = {
+      STRICT_VARIANT_INTERPRETER_LABELS_8(0) STRICT_VARIANT_INTERPRETER_LABELS_8(1)
+        STRICT_VARIANT_INTERPRETER_LABELS_8(2) STRICT_VARIANT_INTERPRETER_LABELS_8(3)
+          STRICT_VARIANT_INTERPRETER_LABELS_8(4) STRICT_VARIANT_INTERPRETER_LABELS_8(5)
+            STRICT_VARIANT_INTERPRETER_LABELS_8(6) STRICT_VARIANT_INTERPRETER_LABELS_8(7)};
+
+    if (pc < 0 || pc >= n) { return pc; }
+    goto *table[first[pc].which()];
+
+    STRICT_VARIANT_INTERPRETER_CASES_8(0)
+    STRICT_VARIANT_INTERPRETER_CASES_8(1)
+    STRICT_VARIANT_INTERPRETER_CASES_8(2)
+    STRICT_VARIANT_INTERPRETER_CASES_8(3)
+    STRICT_VARIANT_INTERPRETER_CASES_8(4)
+    STRICT_VARIANT_INTERPRETER_CASES_8(5)
+    STRICT_VARIANT_INTERPRETER_CASES_8(6)
+    STRICT_VARIANT_INTERPRETER_CASES_8(7)
+  }
+
+#undef STRICT_VARIANT_INTERPRETER_CASES_8
+#undef STRICT_VARIANT_INTERPRETER_CASE
+#undef STRICT_VARIANT_INTERPRETER_LABELS_8
+#undef STRICT_VARIANT_INTERPRETER_LABEL
+
+#pragma GCC diagnostic pop
+};
+
+#else // STRICT_VARIANT_COMPUTED_GOTO
+
+static constexpr unsigned interpreter_max_types = 0;
+
+#endif // STRICT_VARIANT_COMPUTED_GOTO
+
+} // end namespace detail
+
+/***
+ * Run the program [first, last), starting from the instruction at offset
+ * `start`. Each instruction is passed to `handler`, which returns the offset
+ * to the next instruction. Returns the program counter (relative to `first`)
+ * at which execution left the program. The handler is not copied.
+ */
+template <typename Handler, typename RandomIt>
+std::ptrdiff_t
+interpret(Handler && handler, RandomIt first, RandomIt last, std::ptrdiff_t start = 0) {
+  using variant_t =
+    mpl::remove_const_t<mpl::remove_reference_t<decltype(*std::declval<RandomIt>())>>;
+  static_assert(is_variant<variant_t>::value, "interpret requires a range of variants");
+
+  constexpr unsigned num_types = detail::variant_num_types<variant_t>::value;
+  using impl_t = detail::interpreter_impl<num_types, (num_types <= detail::interpreter_max_types)>;
+
+  return impl_t::run(handler, first, static_cast<std::ptrdiff_t>(last - first), start);
+}
+
+} // end namespace strict_variant
+
+#undef STRICT_VARIANT_COMPUTED_GOTO
@@ -125,6 +125,89 @@ struct multivisitor_state<Visitor, TypeList<Vs...>, TypeList<U1, Us...>>
 
 namespace detail {
 
+/***
+ * Flat dispatch for two variants:
+ *   Rather than visiting the first variant, and then the second from within the
+ *   first visitor, we compute a combined index `which1 * N2 + which2`, and
+ *   dispatch once over all N1 * N2 pairs of types. The pair of storages acts as
+ *   the storage, and hands out pairs of values, which an adapter unpacks for
+ *   the visitor. No tuples are built, and the visitor is not copied.
+ */
+// Pair of (forwarding) references to values
+template <typename T1, typename T2>
+struct value_pair {
+  T1 && first;
+  T2 && second;
+};
+
+// Pair of (forwarding) references to storages
+template <typename S1, typename S2, unsigned n2>
+struct storage_pair {
+  S1 && first;
+  S2 && second;
+
+#define FIRST_EXPR std::forward<S1>(first).template get_value<index / n2>(false_{})
+#define SECOND_EXPR std::forward<S2>(second).template get_value<index % n2>(false_{})
+
+  template <std::size_t index>
+  auto get_value(false_) const noexcept
+    -> value_pair<decltype(FIRST_EXPR), decltype(SECOND_EXPR)> {
+    return {FIRST_EXPR, SECOND_EXPR};
+  }
+
+#undef SECOND_EXPR
+#undef FIRST_EXPR
+};
+
+// Adapter which unpacks a value_pair for the visitor
+template <typename Visitor>
+struct pair_visitor {
+  Visitor && visitor;
+
+#define RESULT_EXPR                                                                                \
+  std::forward<Visitor>(visitor)(std::forward<T1>(p.first), std::forward<T2>(p.second))
+
+  template <typename T1, typename T2>
+  auto operator()(value_pair<T1, T2> p) const noexcept(noexcept(RESULT_EXPR))
+    -> decltype(RESULT_EXPR) {
+    return RESULT_EXPR;
+  }
+
+#undef RESULT_EXPR
+};
+
+template <typename V1, typename V2>
+struct flat_dispatch_helper {
+  static constexpr unsigned n1 = variant_num_types<mpl::remove_reference_t<V1>>::value;
+  static constexpr unsigned n2 = variant_num_types<mpl::remove_reference_t<V2>>::value;
+
+  using storage1_t = decltype(storage_access::get(std::declval<V1>()));
+  using storage2_t = decltype(storage_access::get(std::declval<V2>()));
+
+  using storage_t = storage_pair<storage1_t, storage2_t, n2>;
+  using dispatcher_t = visitor_dispatch<false_, n1 * n2, dispatch::default_policy>;
+
+  template <typename Visitor>
+  using result_t = decltype(dispatcher_t{}(0u, std::declval<storage_t &>(),
+                                           std::declval<pair_visitor<Visitor>>()));
+};
+
+template <typename Visitor, typename V1, typename V2>
+auto
+flat_multivisit_impl(Visitor && visitor, V1 && v1, V2 && v2) ->
+  typename flat_dispatch_helper<V1, V2>::template result_t<Visitor> {
+  using helper_t = flat_dispatch_helper<V1, V2>;
+
+  typename helper_t::storage_t storages{storage_access::get(std::forward<V1>(v1)),
+                                        storage_access::get(std::forward<V2>(v2))};
+
+  const unsigned which =
+    static_cast<unsigned>(v1.which()) * helper_t::n2 + static_cast<unsigned>(v2.which());
+
+  return typename helper_t::dispatcher_t{}(which, storages,
+                                           pair_visitor<Visitor>{std::forward<Visitor>(visitor)});
+}
+
 template <typename Visitor, typename... Us>
 auto
 multivisit_impl(Visitor && visitor, Us &&... us) -> decltype(
@@ -137,15 +220,28 @@ multivisit_impl(Visitor && visitor, Us &&... us) -> decltype(
 
 } // end namespace detail
 
-template <typename Visitor, typename V1, typename V2, typename... Vs>
+// Binary visitation uses the flat dispatch
+template <typename Visitor, typename V1, typename V2>
+auto
+apply_visitor(Visitor && vis, V1 && v1, V2 && v2)
+  -> decltype(detail::flat_multivisit_impl(std::forward<Visitor>(std::declval<Visitor>()),
+                                           std::forward<V1>(std::declval<V1>()),
+                                           std::forward<V2>(std::declval<V2>()))) {
+  return detail::flat_multivisit_impl(std::forward<Visitor>(vis), std::forward<V1>(v1),
+                                      std::forward<V2>(v2));
+}
+
+template <typename Visitor, typename V1, typename V2, typename V3, typename... Vs>
 auto
-apply_visitor(Visitor && vis, V1 && v1, V2 && v2, Vs &&... vs)
+apply_visitor(Visitor && vis, V1 && v1, V2 && v2, V3 && v3, Vs &&... vs)
   -> decltype(detail::multivisit_impl(std::forward<Visitor>(std::declval<Visitor>()),
                                       std::forward<V1>(std::declval<V1>()),
                                       std::forward<V2>(std::declval<V2>()),
+                                      std::forward<V3>(std::declval<V3>()),
                                       std::forward<Vs>(std::declval<Vs>())...)) {
   return detail::multivisit_impl(std::forward<Visitor>(vis), std::forward<V1>(v1),
-                                 std::forward<V2>(v2), std::forward<Vs>(vs)...);
+                                 std::forward<V2>(v2), std::forward<V3>(v3),
+                                 std::forward<Vs>(vs)...);
 }
 
 } // end namespace strict_variant
@@ -0,0 +1,335 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A pooling allocator for the nodes of `alloc_wrapper`, for use with
+ * `alloc_variant<pool_allocator>`.
+ *
+ * Each thread has its own cache, with a free list for each size class (in
+ * steps of `alignof(std::max_align_t)`, up to 16 steps). Blocks are carved
+ * from slabs obtained from `operator new`, and each block is preceded by a
+ * small header naming its size class and the cache that owns it. Larger
+ * requests go straight to `operator new`.
+ *
+ * A block freed by its owning thread goes back on that thread's free list,
+ * without synchronization. A block freed by another thread is pushed onto a
+ * lock-free list in the owning cache, which the owner takes over when its own
+ * free list runs dry.
+ *
+ * When a thread exits, its cache is kept, (blocks from it may still be in
+ * use), and is adopted by the next new thread. So the pool never gives memory
+ * back to the system, but it holds at most the peak usage of the threads
+ * alive at once.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+namespace strict_variant {
+
+//[ strict_variant_node_pool_stats
+struct node_pool_stats {
+  std::uint64_t allocations;          // Blocks handed out from the pool
+  std::uint64_t deallocations;        // Blocks returned by the owning thread
+  std::uint64_t remote_deallocations; // Blocks returned by other threads
+  std::uint64_t unpooled;             // Requests too large for the pool
+  std::uint64_t slabs;                // Slabs obtained from `operator new`
+};
+//]
+
+namespace detail {
+
+struct pool_cache;
+
+// Precedes every block handed out by the pool
+struct alignas(std::max_align_t) pool_block_header {
+  pool_cache * owner; // nullptr if the block came straight from `operator new`
+  std::size_t size_class;
+};
+
+// A free block, overlaid on the payload
+struct pool_free_block {
+  pool_free_block * next;
+};
+
+struct node_pool {
+  static constexpr std::size_t granularity = sizeof(pool_block_header);
+  static constexpr std::size_t num_classes = 16;
+  static constexpr std::size_t max_size = granularity * num_classes;
+  static constexpr std::size_t slab_size = 64 * 1024;
+
+  static std::size_t size_class(std::size_t size) noexcept {
+    return size ? (size - 1) / granularity : 0;
+  }
+
+  static void * allocate(std::size_t size);
+  static void deallocate(void * p) noexcept;
+
+  static pool_cache * local_cache();
+};
+
+// Counters which are only written by the thread owning the cache, but may be
+// read by any thread
+inline void
+pool_bump(std::atomic<std::uint64_t> & counter) noexcept {
+  counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+struct pool_cache {
+  pool_free_block * free_lists[node_pool::num_classes];
+  std::atomic<pool_free_block *> remote_free[node_pool::num_classes];
+
+  // Unused part of the current slab
+  char * slab_pos;
+  char * slab_end;
+
+  std::atomic<std::uint64_t> allocations;
+  std::atomic<std::uint64_t> deallocations;
+  std::atomic<std::uint64_t> remote_deallocations; // Written by other threads
+  std::atomic<std::uint64_t> unpooled;
+  std::atomic<std::uint64_t> slabs;
+
+  pool_cache * next_cache;  // All the caches
+  pool_cache * next_orphan; // Caches whose thread has exited
+
+  pool_cache() noexcept
+    : slab_pos(nullptr)
+    , slab_end(nullptr)
+    , allocations(0)
+    , deallocations(0)
+    , remote_deallocations(0)
+    , unpooled(0)
+    , slabs(0)
+    , next_cache(nullptr)
+    , next_orphan(nullptr) {
+    for (std::size_t i = 0; i < node_pool::num_classes; ++i) {
+      free_lists[i] = nullptr;
+      remote_free[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  pool_cache(const pool_cache &) = delete;
+  pool_cache & operator=(const pool_cache &) = delete;
+
+  // Take the blocks freed by other threads, or else carve a new block
+  pool_free_block * refill(std::size_t c) {
+    if (pool_free_block * b = remote_free[c].exchange(nullptr, std::memory_order_acquire)) {
+      return b;
+    }
+
+    const std::size_t block_size = sizeof(pool_block_header) + (c + 1) * node_pool::granularity;
+    if (static_cast<std::size_t>(slab_end - slab_pos) < block_size) {
+      slab_pos = static_cast<char *>(::operator new(node_pool::slab_size));
+      slab_end = slab_pos + node_pool::slab_size;
+      pool_bump(slabs);
+    }
+
+    pool_block_header * h = reinterpret_cast<pool_block_header *>(slab_pos);
+    slab_pos += block_size;
+    h->owner = this;
+    h->size_class = c;
+    pool_free_block * b = reinterpret_cast<pool_free_block *>(h + 1);
+    b->next = nullptr;
+    return b;
+  }
+
+  void * allocate(std::size_t c) {
+    pool_free_block * b = free_lists[c];
+    if (!b) { b = this->refill(c); }
+    free_lists[c] = b->next;
+    pool_bump(allocations);
+    return b;
+  }
+
+  void deallocate_local(pool_free_block * b, std::size_t c) noexcept {
+    b->next = free_lists[c];
+    free_lists[c] = b;
+    pool_bump(deallocations);
+  }
+
+  void deallocate_remote(pool_free_block * b, std::size_t c) noexcept {
+    b->next = remote_free[c].load(std::memory_order_relaxed);
+    while (!remote_free[c].compare_exchange_weak(b->next, b, std::memory_order_release,
+                                                 std::memory_order_relaxed)) {}
+    remote_deallocations.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void add_to(node_pool_stats & s) const noexcept {
+    s.allocations += allocations.load(std::memory_order_relaxed);
+    s.deallocations += deallocations.load(std::memory_order_relaxed);
+    s.remote_deallocations += remote_deallocations.load(std::memory_order_relaxed);
+    s.unpooled += unpooled.load(std::memory_order_relaxed);
+    s.slabs += slabs.load(std::memory_order_relaxed);
+  }
+};
+
+// Owns all of the caches. Neither it nor the caches are ever destroyed, since
+// blocks may be freed by threads which outlive the static destructors.
+struct pool_registry {
+  std::mutex mutex;
+  pool_cache * caches;
+  pool_cache * orphans;
+
+  pool_registry() noexcept
+    : caches(nullptr)
+    , orphans(nullptr) {}
+
+  pool_cache * acquire() {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (pool_cache * c = orphans) {
+      orphans = c->next_orphan;
+      c->next_orphan = nullptr;
+      return c;
+    }
+    pool_cache * c = new pool_cache;
+    c->next_cache = caches;
+    caches = c;
+    return c;
+  }
+
+  void release(pool_cache * c) noexcept {
+    std::lock_guard<std::mutex> lock{mutex};
+    c->next_orphan = orphans;
+    orphans = c;
+  }
+
+  node_pool_stats stats() {
+    node_pool_stats result{};
+    std::lock_guard<std::mutex> lock{mutex};
+    for (pool_cache * c = caches; c; c = c->next_cache) {
+      c->add_to(result);
+    }
+    return result;
+  }
+
+  static pool_registry & get() {
+    static pool_registry * const instance = new pool_registry;
+    return *instance;
+  }
+};
+
+// The cache of the current thread. (Trivially destructible, so that it can
+// still be read while other thread-local objects are destroyed.)
+inline pool_cache *&
+pool_local_cache_ptr() noexcept {
+  static thread_local pool_cache * instance = nullptr;
+  return instance;
+}
+
+inline bool &
+pool_thread_exited() noexcept {
+  static thread_local bool instance = false;
+  return instance;
+}
+
+// Gives the cache back to the registry when the thread exits
+struct pool_thread {
+  pool_cache * cache;
+
+  pool_thread()
+    : cache(pool_registry::get().acquire()) {
+    pool_local_cache_ptr() = cache;
+  }
+
+  ~pool_thread() {
+    pool_local_cache_ptr() = nullptr;
+    pool_thread_exited() = true;
+    pool_registry::get().release(cache);
+  }
+};
+
+// nullptr once the thread's cache is given back, then the pool isn't used
+inline pool_cache *
+node_pool::local_cache() {
+  if (pool_cache * c = pool_local_cache_ptr()) { return c; }
+  if (pool_thread_exited()) { return nullptr; }
+  static thread_local pool_thread thread;
+  return thread.cache;
+}
+
+inline void *
+node_pool::allocate(std::size_t size) {
+  if (size <= max_size) {
+    if (pool_cache * c = local_cache()) { return c->allocate(size_class(size)); }
+  }
+
+  pool_block_header * h =
+    static_cast<pool_block_header *>(::operator new(sizeof(pool_block_header) + size));
+  h->owner = nullptr;
+  h->size_class = 0;
+  if (pool_cache * c = pool_local_cache_ptr()) { pool_bump(c->unpooled); }
+  return h + 1;
+}
+
+inline void
+node_pool::deallocate(void * p) noexcept {
+  if (!p) { return; }
+  pool_block_header * h = static_cast<pool_block_header *>(p) - 1;
+  pool_free_block * b = static_cast<pool_free_block *>(p);
+  if (!h->owner) {
+    ::operator delete(h);
+  } else if (h->owner == pool_local_cache_ptr()) {
+    h->owner->deallocate_local(b, h->size_class);
+  } else {
+    h->owner->deallocate_remote(b, h->size_class);
+  }
+}
+
+} // end namespace detail
+
+//[ strict_variant_pool_allocator
+template <typename T>
+struct pool_allocator {
+  typedef T value_type;
+
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+                "pool_allocator does not support over-aligned types");
+
+  pool_allocator() noexcept = default;
+
+  template <typename U>
+  pool_allocator(const pool_allocator<U> &) noexcept {}
+
+  T * allocate(std::size_t n) {
+    return static_cast<T *>(detail::node_pool::allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T * p, std::size_t) noexcept { detail::node_pool::deallocate(p); }
+};
+
+template <typename T, typename U>
+constexpr bool
+operator==(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+  return true;
+}
+
+template <typename T, typename U>
+constexpr bool
+operator!=(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+  return false;
+}
+
+// Totals over all threads
+inline node_pool_stats
+pool_allocator_stats() {
+  return detail::pool_registry::get().stats();
+}
+
+// Counts of the cache used by the current thread
+inline node_pool_stats
+pool_allocator_thread_stats() {
+  node_pool_stats result{};
+  if (detail::pool_cache * c = detail::node_pool::local_cache()) { c->add_to(result); }
+  return result;
+}
+//]
+
+} // end namespace strict_variant
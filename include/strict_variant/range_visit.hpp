@@ -0,0 +1,315 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Batch visitation over a range of variants.
+ *
+ * Rather than dispatching once per element, the elements are first bucketed
+ * by `which()`: a counting pass finds the size of each bucket, and a scatter
+ * pass writes the position of each element into its bucket. Then there is one
+ * loop per type, which knows the type statically, so there is no dispatch and
+ * no test of `which()` in the inner loop, and the optimizer is free to unroll
+ * or vectorize it.
+ *
+ * So the elements holding the first type are visited first, then those holding
+ * the second type, and so on. Elements of the same type are visited in order.
+ *
+ * If the visitor must see the elements in order, pass `in_order_tag` first.
+ * Then we dispatch once per *run* of consecutive elements which hold the same
+ * type instead. The benefit depends on how long the runs are -- if the types
+ * are clustered, (e.g. the range was sorted or partitioned by `which()`),
+ * there will be very few dispatches.
+ */
+
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_dispatch.hpp>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+// Tag requesting that `apply_visitor_range` visits the elements in order
+struct in_order_tag {};
+
+namespace detail {
+
+#define VALUE_EXPR storage_access::get(*it).template get_value<index>(false_{})
+
+/***
+ * Bucketed visitation
+ */
+
+// The positions of the elements of a range, grouped by `which()`. Bucket `i`
+// is `[positions[offsets[i]], positions[offsets[i + 1]])`, in order.
+//
+// If many consecutive elements hold the same type, incrementing one counter
+// for each of them is a chain of dependent loads and stores. So the range is
+// split into `num_chunks` parts, which are counted and scattered in an
+// interleaved loop, each with its own counters.
+template <std::size_t num_types>
+struct range_buckets {
+  static constexpr std::size_t num_chunks = 4;
+
+  std::size_t offsets[num_types + 1];
+  std::vector<std::size_t> positions;
+
+  template <typename Iterator>
+  range_buckets(Iterator first, std::size_t size)
+    : offsets()
+    , positions(size) {
+    // The last chunk also takes the remainder
+    const std::size_t len = size / num_chunks;
+    const std::size_t tail = num_chunks * len;
+
+    // Counting pass
+    std::size_t counts[num_chunks][num_types] = {};
+    for (std::size_t i = 0; i < len; ++i) {
+      for (std::size_t c = 0; c < num_chunks; ++c) {
+        ++counts[c][static_cast<std::size_t>(first[c * len + i].which())];
+      }
+    }
+    for (std::size_t i = tail; i < size; ++i) {
+      ++counts[num_chunks - 1][static_cast<std::size_t>(first[i].which())];
+    }
+
+    // Within a bucket, the elements of each chunk follow those of the last
+    std::size_t next[num_chunks][num_types];
+    for (std::size_t t = 0; t < num_types; ++t) {
+      std::size_t pos = offsets[t];
+      for (std::size_t c = 0; c < num_chunks; ++c) {
+        next[c][t] = pos;
+        pos += counts[c][t];
+      }
+      offsets[t + 1] = pos;
+    }
+
+    // Scatter pass
+    for (std::size_t i = 0; i < len; ++i) {
+      for (std::size_t c = 0; c < num_chunks; ++c) {
+        const std::size_t j = c * len + i;
+        positions[next[c][static_cast<std::size_t>(first[j].which())]++] = j;
+      }
+    }
+    for (std::size_t i = tail; i < size; ++i) {
+      positions[next[num_chunks - 1][static_cast<std::size_t>(first[i].which())]++] = i;
+    }
+  }
+};
+
+// Applies the visitor to each element of the bucket for `index`, discards the
+// results.
+template <typename Visitor, typename Iterator>
+struct bucket_visitor {
+  Visitor & visitor;
+  Iterator first;
+
+  template <std::size_t index>
+  void visit(const std::size_t * pos, const std::size_t * end) const {
+    for (; pos != end; ++pos) {
+      Iterator it = first + *pos;
+      visitor(VALUE_EXPR);
+    }
+  }
+};
+
+// Applies the visitor to each element of the bucket for `index`, writes the
+// result for the element at position `i` to `out[i]`.
+template <typename Visitor, typename Iterator, typename OutputIterator>
+struct bucket_output_visitor {
+  Visitor & visitor;
+  Iterator first;
+  OutputIterator out;
+
+  template <std::size_t index>
+  void visit(const std::size_t * pos, const std::size_t * end) const {
+    for (; pos != end; ++pos) {
+      Iterator it = first + *pos;
+      out[*pos] = visitor(VALUE_EXPR);
+    }
+  }
+};
+
+// Runs the bucket visitor on each bucket, in order of the index
+template <std::size_t index, std::size_t num_types>
+struct visit_buckets {
+  template <typename BucketVisitor>
+  static void run(const range_buckets<num_types> & buckets, const BucketVisitor & vis) {
+    const std::size_t * positions = buckets.positions.data();
+    vis.template visit<index>(positions + buckets.offsets[index],
+                              positions + buckets.offsets[index + 1]);
+    visit_buckets<index + 1, num_types>::run(buckets, vis);
+  }
+};
+
+template <std::size_t num_types>
+struct visit_buckets<num_types, num_types> {
+  template <typename BucketVisitor>
+  static void run(const range_buckets<num_types> &, const BucketVisitor &) {}
+};
+
+/***
+ * In-order visitation
+ */
+
+// A run of elements from `it` to `last`, all of which hold the type at
+// `index`, up to the first one which doesn't.
+template <std::size_t index, typename Iterator>
+struct typed_run {
+  Iterator it;
+  Iterator last;
+};
+
+// Stands in for the storage for the dispatcher, hands out typed_run objects
+template <typename Iterator>
+struct run_storage {
+  Iterator it;
+  Iterator last;
+
+  template <std::size_t index>
+  typed_run<index, Iterator> get_value(false_) const noexcept {
+    return {it, last};
+  }
+};
+
+// Applies the visitor to each element of a run, discards the results.
+// Returns an iterator to the end of the run.
+template <typename Visitor>
+struct run_visitor {
+  Visitor & visitor;
+
+  template <std::size_t index, typename Iterator>
+  Iterator operator()(typed_run<index, Iterator> run) const {
+    Iterator it = run.it;
+    do {
+      visitor(VALUE_EXPR);
+      ++it;
+    } while (it != run.last && static_cast<std::size_t>(it->which()) == index);
+    return it;
+  }
+};
+
+// Applies the visitor to each element of a run, writes the results to `out`.
+// Returns an iterator to the end of the run.
+template <typename Visitor, typename OutputIterator>
+struct run_output_visitor {
+  Visitor & visitor;
+  OutputIterator & out;
+
+  template <std::size_t index, typename Iterator>
+  Iterator operator()(typed_run<index, Iterator> run) const {
+    Iterator it = run.it;
+    do {
+      *out = visitor(VALUE_EXPR);
+      ++out;
+      ++it;
+    } while (it != run.last && static_cast<std::size_t>(it->which()) == index);
+    return it;
+  }
+};
+
+#undef VALUE_EXPR
+
+template <typename Iterator>
+struct range_dispatch_helper {
+  using variant_t =
+    mpl::remove_const_t<mpl::remove_reference_t<decltype(*std::declval<Iterator>())>>;
+
+  static_assert(is_variant<variant_t>::value, "apply_visitor_range requires a range of variants");
+
+  static constexpr std::size_t num_types = variant_num_types<variant_t>::value;
+
+  using dispatcher_t =
+    visitor_dispatch<false_, num_types, typename dispatch_policy<variant_t>::type>;
+};
+
+template <typename Iterator>
+struct is_random_access_iterator
+  : std::is_base_of<std::random_access_iterator_tag,
+                    typename std::iterator_traits<Iterator>::iterator_category> {};
+
+} // end namespace detail
+
+/***
+ * Apply a visitor to each variant in the range [first, last), grouped by
+ * type: all the elements holding the first type, in order, then all those
+ * holding the second type, and so on.
+ * The visitor is taken by reference and is not copied.
+ */
+template <typename Visitor, typename Iterator>
+void
+apply_visitor_range(Visitor && visitor, Iterator first, Iterator last) {
+  static_assert(detail::is_random_access_iterator<Iterator>::value,
+                "apply_visitor_range requires random access iterators, use in_order_tag");
+  using helper_t = detail::range_dispatch_helper<Iterator>;
+  constexpr std::size_t num_types = helper_t::num_types;
+
+  const detail::range_buckets<num_types> buckets(first, static_cast<std::size_t>(last - first));
+  const detail::bucket_visitor<mpl::remove_reference_t<Visitor>, Iterator> vis{visitor, first};
+  detail::visit_buckets<0, num_types>::run(buckets, vis);
+}
+
+/***
+ * Apply a visitor to each variant in the range [first, last), grouped by type
+ * as above, and write the result for the element `first[i]` to `out[i]`.
+ * Returns the output iterator, one past the last element written.
+ */
+template <typename Visitor, typename Iterator, typename OutputIterator>
+OutputIterator
+apply_visitor_range(Visitor && visitor, Iterator first, Iterator last, OutputIterator out) {
+  static_assert(detail::is_random_access_iterator<Iterator>::value
+                  && detail::is_random_access_iterator<OutputIterator>::value,
+                "apply_visitor_range requires random access iterators, use in_order_tag");
+  using helper_t = detail::range_dispatch_helper<Iterator>;
+  constexpr std::size_t num_types = helper_t::num_types;
+
+  const std::size_t size = static_cast<std::size_t>(last - first);
+  const detail::range_buckets<num_types> buckets(first, size);
+  const detail::bucket_output_visitor<mpl::remove_reference_t<Visitor>, Iterator, OutputIterator>
+    vis{visitor, first, out};
+  detail::visit_buckets<0, num_types>::run(buckets, vis);
+  return out + size;
+}
+
+/***
+ * Apply a visitor to each variant in the range [first, last), in order.
+ * The visitor is taken by reference and is not copied.
+ */
+template <typename Visitor, typename Iterator>
+void
+apply_visitor_range(in_order_tag, Visitor && visitor, Iterator first, Iterator last) {
+  using dispatcher_t = typename detail::range_dispatch_helper<Iterator>::dispatcher_t;
+
+  detail::run_visitor<mpl::remove_reference_t<Visitor>> vis{visitor};
+  while (first != last) {
+    detail::run_storage<Iterator> storage{first, last};
+    first = dispatcher_t{}(static_cast<unsigned>(first->which()), storage, vis);
+  }
+}
+
+/***
+ * Apply a visitor to each variant in the range [first, last), in order,
+ * and write the results to `out`. Returns the output iterator, one past the
+ * last element written.
+ */
+template <typename Visitor, typename Iterator, typename OutputIterator>
+OutputIterator
+apply_visitor_range(in_order_tag, Visitor && visitor, Iterator first, Iterator last,
+                    OutputIterator out) {
+  using dispatcher_t = typename detail::range_dispatch_helper<Iterator>::dispatcher_t;
+
+  detail::run_output_visitor<mpl::remove_reference_t<Visitor>, OutputIterator> vis{visitor, out};
+  while (first != last) {
+    detail::run_storage<Iterator> storage{first, last};
+    first = dispatcher_t{}(static_cast<unsigned>(first->which()), storage, vis);
+  }
+  return out;
+}
+
+} // end namespace strict_variant
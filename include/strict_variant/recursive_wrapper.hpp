@@ -8,7 +8,10 @@
 /***
  * For use with strict_variant::variant
  */
+#include <cstdint>
 #include <new>
+#include <strict_variant/relocate.hpp>
+#include <strict_variant/teardown.hpp>
 #include <strict_variant/variant_fwd.hpp>
 #include <strict_variant/wrapper.hpp>
 #include <type_traits>
@@ -32,28 +35,130 @@
 
 #endif // STRICT_VARIANT_DEBUG
 
-//[ strict_variant_recursive_wrapper
 namespace strict_variant {
 
-template <typename T>
-class recursive_wrapper {
+namespace detail {
+
+struct wrapper_reuse;
+
+/***
+ * The implementation of `recursive_wrapper` and `heap_wrapper`: an owning
+ * pointer to a `T` on the heap. If `Global` is `std::true_type`, the value is
+ * allocated in a `global_node`, which is aligned enough for the low bits of
+ * the pointer to hold a tag. Otherwise it is allocated with the class-specific
+ * allocation functions of `T`, and the pointer is not tagged.
+ */
+template <typename T, typename Global>
+class heap_node {
   T * m_t;
 
-  void destroy() { delete m_t; }
+  // When this is held in a pointer-sized variant, the low bits of `m_t` hold
+  // the variant's `which`, and must be masked off.
+  static constexpr std::uintptr_t tag_mask() noexcept {
+    return Global::value ? pointer_tag_mask : 0;
+  }
+
+  T * ptr() const noexcept {
+    return reinterpret_cast<T *>(reinterpret_cast<std::uintptr_t>(m_t) & ~tag_mask());
+  }
+
+  template <typename... Args>
+  static T * allocate(std::true_type, Args &&... args) {
+    typename global_node<T>::guard g{global_node<T>::allocate()};
+    T * result = ::new (g.p) T(std::forward<Args>(args)...);
+    g.p = nullptr;
+    return result;
+  }
+
+  template <typename... Args>
+  static T * allocate(std::false_type, Args &&... args) {
+    return new T(std::forward<Args>(args)...);
+  }
+
+protected:
+  // Heap node reuse, see `detail::wrapper_reuse`.
+  friend struct detail::wrapper_reuse;
+
+  struct reuse_tag {};
+
+  heap_node() noexcept
+    : m_t(nullptr) {}
+
+  // Construct the value in an allocation taken from another wrapper
+  template <typename... Args>
+  heap_node(reuse_tag, void * p, Args &&... args) noexcept(
+    std::is_nothrow_constructible<T, Args...>::value)
+    : m_t(::new (p) T(std::forward<Args>(args)...)) {}
+
+  // Pointer move. The tag bits of `rhs` (if any) are left in place.
+  heap_node(heap_node && rhs) noexcept //
+    : m_t(rhs.ptr())                   //
+  {
+    rhs.m_t = reinterpret_cast<T *>(reinterpret_cast<std::uintptr_t>(rhs.m_t) & tag_mask());
+  }
+
+  heap_node(const heap_node &) = delete;
+  heap_node & operator=(const heap_node &) = delete;
+  heap_node & operator=(heap_node &&) = delete;
+
+  ~heap_node() noexcept { detail::delete_wrapped<Global>(this->ptr()); }
 
   template <typename... Args>
   void init(Args &&... args) {
-    m_t = new T(std::forward<Args>(args)...);
+    m_t = allocate(Global{}, std::forward<Args>(args)...);
+    STRICT_VARIANT_ASSERT(!(reinterpret_cast<std::uintptr_t>(m_t) & tag_mask()),
+                          "Allocation is not sufficiently aligned!");
+  }
+
+  // Destroy the value, but keep the allocation and return it. Afterwards
+  // the wrapper is empty, and may only be destroyed.
+  void * reclaim() noexcept {
+    T * p = this->ptr();
+    p->~T();
+    m_t = reinterpret_cast<T *>(reinterpret_cast<std::uintptr_t>(m_t) & tag_mask());
+    return static_cast<void *>(p);
   }
 
 public:
-  typedef T value_type;
+  T & get() & {
+    STRICT_VARIANT_ASSERT(this->ptr(), "Bad access!");
+    return *this->ptr();
+  }
+  const T & get() const & {
+    STRICT_VARIANT_ASSERT(this->ptr(), "Bad access!");
+    return *this->ptr();
+  }
+  T && get() && {
+    STRICT_VARIANT_ASSERT(this->ptr(), "Bad access!");
+    return std::move(*this->ptr());
+  }
+};
 
-  ~recursive_wrapper() noexcept { this->destroy(); }
+} // end namespace detail
+
+//[ strict_variant_recursive_wrapper
+/***
+ * The value is allocated in a `global_node`, ignoring any class-specific
+ * `operator new` of `T`, which may not align to `max_align_t`. Whether the
+ * variant is pointer-sized is decided where `T` may be incomplete, so we can't
+ * check for one there.
+ */
+template <typename T>
+class recursive_wrapper : public detail::heap_node<T, std::true_type> {
+  using base_t = detail::heap_node<T, std::true_type>;
+
+  friend struct detail::wrapper_reuse;
+
+  template <typename... Args>
+  recursive_wrapper(typename base_t::reuse_tag tag, void * p, Args &&... args) noexcept(
+    std::is_nothrow_constructible<T, Args...>::value)
+    : base_t(tag, p, std::forward<Args>(args)...) {}
+
+public:
+  typedef T value_type;
 
   template <typename... Args>
-  recursive_wrapper(Args &&... args)
-    : m_t(nullptr) {
+  recursive_wrapper(Args &&... args) {
     this->init(std::forward<Args>(args)...);
   }
 
@@ -61,42 +166,186 @@ public:
     : recursive_wrapper(static_cast<const recursive_wrapper &>(rhs)) {}
 
   recursive_wrapper(const recursive_wrapper & rhs)
-    : m_t(nullptr) {
+    : base_t() {
     this->init(rhs.get());
   }
 
-  // Pointer move
-  recursive_wrapper(recursive_wrapper && rhs) noexcept //
-    : m_t(rhs.m_t)                                     //
-  {
-    rhs.m_t = nullptr;
-  }
+  recursive_wrapper(recursive_wrapper &&) noexcept = default;
 
   // Not assignable, we never actually need this, and it adds complexity
   // associated to lifetime of `m_t` object.
   recursive_wrapper & operator=(const recursive_wrapper &) = delete;
   recursive_wrapper & operator=(recursive_wrapper &&) = delete;
+};
+//]
 
-  T & get() & {
-    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
-    return *m_t;
-  }
-  const T & get() const & {
-    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
-    return *m_t;
+//[ strict_variant_heap_wrapper
+/***
+ * Like `recursive_wrapper`, but `T` must be complete wherever the wrapper is
+ * used. In return, the `noexcept` traits of the variant interrogate `T`,
+ * instead of assuming the worst.
+ *
+ * Unlike `recursive_wrapper`, this uses the class-specific allocation
+ * functions of `T`, if any. Then the pointer may not be aligned enough to be
+ * tagged, and the variant keeps `which` separately.
+ */
+template <typename T>
+class heap_wrapper
+  : public detail::heap_node<
+      T, std::integral_constant<bool, !detail::has_class_allocation<T>::value>> {
+  static_assert(sizeof(T) > 0, "heap_wrapper requires a complete type, use recursive_wrapper");
+  static_assert(std::is_nothrow_destructible<T>::value,
+                "heap_wrapper requires a nothrow destructible type");
+
+  using base_t =
+    detail::heap_node<T, std::integral_constant<bool, !detail::has_class_allocation<T>::value>>;
+
+  friend struct detail::wrapper_reuse;
+
+  template <typename... Args>
+  heap_wrapper(typename base_t::reuse_tag tag, void * p, Args &&... args) noexcept(
+    std::is_nothrow_constructible<T, Args...>::value)
+    : base_t(tag, p, std::forward<Args>(args)...) {}
+
+public:
+  typedef T value_type;
+
+  template <typename... Args>
+  heap_wrapper(Args &&... args) {
+    this->init(std::forward<Args>(args)...);
   }
-  T && get() && {
-    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
-    return std::move(*m_t);
+
+  heap_wrapper(heap_wrapper & rhs)
+    : heap_wrapper(static_cast<const heap_wrapper &>(rhs)) {}
+
+  heap_wrapper(const heap_wrapper & rhs)
+    : base_t() {
+    this->init(rhs.get());
   }
+
+  heap_wrapper(heap_wrapper &&) noexcept = default;
+
+  heap_wrapper & operator=(const heap_wrapper &) = delete;
+  heap_wrapper & operator=(heap_wrapper &&) = delete;
 };
 //]
 
+// Just a pointer to the heap, so it can be moved by copying the bytes
+template <typename T>
+struct is_trivially_relocatable<recursive_wrapper<T>> : std::true_type {};
+
+template <typename T>
+struct is_trivially_relocatable<heap_wrapper<T>> : std::true_type {};
+
 namespace detail {
 
 template <typename T>
 struct is_wrapper<recursive_wrapper<T>> : std::true_type {};
 
+template <typename T>
+struct is_tagged_pointer_wrapper<recursive_wrapper<T>> : std::true_type {};
+
+template <typename T>
+struct is_wrapper<heap_wrapper<T>> : std::true_type {};
+
+template <typename T>
+struct is_tagged_pointer_wrapper<heap_wrapper<T>>
+  : std::integral_constant<bool, !has_class_allocation<T>::value> {};
+
+template <typename T>
+struct is_complete_wrapper<heap_wrapper<T>> : std::true_type {};
+
+/***
+ * Heap node reuse
+ *
+ * When a variant holding `recursive_wrapper<U>` is changed to hold
+ * `recursive_wrapper<T>`, and `T` and `U` have the same size and alignment,
+ * the new value can be constructed in the old allocation. (They must be the
+ * same, and not just large enough, because `delete` may pass the size to the
+ * deallocation function.) The same goes for `heap_wrapper`.
+ *
+ * The node must also be freed by the deallocation function matching the one
+ * that allocated it. `recursive_wrapper` always uses the global ones, and
+ * `heap_wrapper<T>` uses those of `T`, if it has class-specific ones. So
+ * nodes using class-specific functions are only reused for the same type.
+ */
+struct wrapper_reuse {
+  template <typename U, typename T>
+  struct same_layout
+    : std::integral_constant<bool, sizeof(U) == sizeof(T) && alignof(U) == alignof(T)> {};
+
+  // The type whose allocation functions allocate the node of a wrapper, or
+  // `void` for the global ones
+  template <typename W>
+  struct node_allocation;
+
+  template <typename T>
+  struct node_allocation<recursive_wrapper<T>> {
+    using type = void;
+  };
+
+  template <typename T>
+  struct node_allocation<heap_wrapper<T>> {
+    using type = typename std::conditional<has_class_allocation<T>::value, T, void>::type;
+  };
+
+  template <typename From, typename To>
+  struct same_node
+    : std::integral_constant<bool,
+                             same_layout<typename From::value_type, typename To::value_type>::value
+                               && std::is_same<typename node_allocation<From>::type,
+                                               typename node_allocation<To>::type>::value> {};
+
+  template <typename From, typename To>
+  struct compatible : std::false_type {};
+
+  template <typename U, typename T>
+  struct compatible<recursive_wrapper<U>, recursive_wrapper<T>>
+    : same_node<recursive_wrapper<U>, recursive_wrapper<T>> {};
+
+  template <typename U, typename T>
+  struct compatible<recursive_wrapper<U>, heap_wrapper<T>>
+    : same_node<recursive_wrapper<U>, heap_wrapper<T>> {};
+
+  template <typename U, typename T>
+  struct compatible<heap_wrapper<U>, recursive_wrapper<T>>
+    : same_node<heap_wrapper<U>, recursive_wrapper<T>> {};
+
+  template <typename U, typename T>
+  struct compatible<heap_wrapper<U>, heap_wrapper<T>>
+    : same_node<heap_wrapper<U>, heap_wrapper<T>> {};
+
+  template <typename To>
+  struct compatible_with {
+    template <typename From>
+    struct prop : compatible<From, To> {};
+  };
+
+  // Returns the allocation of a wrapper, after destroying its value, or
+  // nullptr if the allocation can't be used for `To`.
+  template <typename To, typename From>
+  static void * reclaim(From & from) noexcept {
+    return reclaim(from, std::integral_constant<bool, compatible<From, To>::value>{});
+  }
+
+  template <typename From>
+  static void * reclaim(From &, std::false_type) noexcept {
+    return nullptr;
+  }
+
+  template <typename From>
+  static void * reclaim(From & from, std::true_type) noexcept {
+    return from.reclaim();
+  }
+
+  // Construct a wrapper `To` in an allocation obtained from `reclaim`
+  template <typename To, typename... Args>
+  static To construct(void * p, Args &&... args) noexcept(
+    std::is_nothrow_constructible<typename To::value_type, Args...>::value) {
+    return To(typename To::reuse_tag{}, p, std::forward<Args>(args)...);
+  }
+};
+
 } // end namespace detail
 
 } // end namespace strict_variant
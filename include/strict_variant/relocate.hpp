@@ -0,0 +1,101 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/***
+ * Trivial relocation
+ *
+ * To "relocate" an object is to move construct a new object from it, and then
+ * destroy the old one. A type is "trivially relocatable" if this has the same
+ * effect as copying the bytes with `memcpy`, (and not destroying the old one).
+ *
+ * Every trivially copyable type is trivially relocatable. But many others are
+ * too, such as types which own a heap allocation through a pointer, like
+ * `recursive_wrapper`, or `std::unique_ptr`. Types which hold a pointer into
+ * themselves are not, like `std::string` in libstdc++.
+ *
+ * This trait is opt-in: specialize it to `std::true_type` for your types.
+ * A variant is trivially relocatable if all of its types are.
+ */
+
+namespace strict_variant {
+
+namespace detail {
+
+/***
+ * libstdc++ before gcc 5 doesn't have `std::is_trivially_copyable`, so we use
+ * the compiler intrinsics there.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ < 5)
+template <typename T>
+struct is_trivially_copyable
+  : std::integral_constant<bool, __has_trivial_copy(T) && __has_trivial_assign(T)
+                                   && __has_trivial_destructor(T)> {};
+#else
+template <typename T>
+struct is_trivially_copyable : std::is_trivially_copyable<T> {};
+#endif
+
+} // end namespace detail
+
+//[ strict_variant_is_trivially_relocatable
+template <typename T>
+struct is_trivially_relocatable : detail::is_trivially_copyable<T> {};
+//]
+
+namespace detail {
+
+template <typename T>
+T *
+relocate_impl(T * first, T * last, T * dest, std::true_type) noexcept {
+  const std::size_t n = static_cast<std::size_t>(last - first);
+  if (n) {
+    std::memcpy(static_cast<void *>(dest), static_cast<const void *>(first), n * sizeof(T));
+  }
+  return dest + n;
+}
+
+template <typename T>
+T *
+relocate_impl(T * first, T * last, T * dest,
+              std::false_type) noexcept(std::is_nothrow_move_constructible<T>::value) {
+  static_assert(std::is_nothrow_move_constructible<T>::value,
+                "relocate requires a type which is trivially relocatable or nothrow move "
+                "constructible");
+  for (; first != last; ++first, ++dest) {
+    new (static_cast<void *>(dest)) T(std::move(*first));
+    first->~T();
+  }
+  return dest;
+}
+
+} // end namespace detail
+
+/***
+ * Relocate the objects in `[first, last)` to uninitialized storage starting at
+ * `dest`. Afterwards, `[first, last)` is uninitialized storage, and the objects
+ * live in `[dest, dest + (last - first))`. The ranges must not overlap.
+ * Returns the end of the destination range.
+ *
+ * Uses `memcpy` if `T` is trivially relocatable, and otherwise move constructs
+ * and destroys each object.
+ */
+//[ strict_variant_relocate
+template <typename T>
+T *
+relocate(T * first, T * last, T * dest) noexcept {
+  return detail::relocate_impl(first, last, dest,
+                               std::integral_constant<bool, is_trivially_relocatable<T>::value>{});
+}
+//]
+
+} // end namespace strict_variant
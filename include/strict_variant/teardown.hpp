@@ -0,0 +1,165 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <strict_variant/wrapper.hpp>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+/***
+ * Iterative destruction
+ *
+ * Destroying a `recursive_wrapper` deletes its value, which destroys the
+ * variants in that value, which destroy their wrappers, and so on. So the
+ * depth of the call stack is proportional to the depth of the structure, and
+ * destroying a long list can overflow the stack.
+ *
+ * If `iterative_destruction<T>` is true, then when a wrapper of `T` is
+ * destroyed while another such wrapper is being destroyed in the same thread,
+ * its value is not deleted right away. Instead it is pushed onto a work list
+ * held by the outermost one, which deletes the values on the list in a loop,
+ * before it returns. So the depth of the call stack doesn't depend on the
+ * structure.
+ *
+ * This trait is opt-in: specialize it to `std::true_type` for the recursive
+ * types of your structure. It is used by `recursive_wrapper` and
+ * `heap_wrapper`.
+ */
+
+namespace strict_variant {
+
+//[ strict_variant_iterative_destruction
+template <typename T>
+struct iterative_destruction : std::false_type {};
+//]
+
+namespace detail {
+
+// Delete a value allocated in a `global_node`, ignoring any class-specific
+// deallocation function, or with plain `new`.
+template <typename T>
+void
+delete_node(T * p, std::true_type) noexcept {
+  if (!p) { return; }
+  p->~T();
+  global_node<T>::deallocate(p);
+}
+
+template <typename T>
+void
+delete_node(T * p, std::false_type) noexcept {
+  delete p;
+}
+
+/***
+ * The values waiting to be deleted. It lives on the stack of the outermost
+ * wrapper destructor, and grows onto the heap if needed.
+ */
+class teardown_list {
+  struct entry {
+    void * value;
+    void (*destroy)(void *);
+  };
+
+  static constexpr std::size_t inline_capacity = 32;
+
+  entry m_inline[inline_capacity];
+  entry * m_entries;
+  std::size_t m_size;
+  std::size_t m_capacity;
+
+  template <typename Global, typename T>
+  static void delete_value(void * p) noexcept {
+    detail::delete_node(static_cast<T *>(p), Global{});
+  }
+
+  bool grow() noexcept {
+    const std::size_t capacity = 2 * m_capacity;
+    entry * entries = new (std::nothrow) entry[capacity];
+    if (!entries) { return false; }
+    std::memcpy(static_cast<void *>(entries), m_entries, m_size * sizeof(entry));
+    if (m_entries != m_inline) { delete[] m_entries; }
+    m_entries = entries;
+    m_capacity = capacity;
+    return true;
+  }
+
+public:
+  teardown_list() noexcept
+    : m_entries(m_inline)
+    , m_size(0)
+    , m_capacity(inline_capacity) {}
+
+  ~teardown_list() noexcept {
+    if (m_entries != m_inline) { delete[] m_entries; }
+  }
+
+  teardown_list(const teardown_list &) = delete;
+  teardown_list & operator=(const teardown_list &) = delete;
+
+  // Returns false if the list is full and can't grow, and then the caller
+  // must delete the value itself.
+  template <typename Global, typename T>
+  bool push(T * p) noexcept {
+    if (m_size == m_capacity && !this->grow()) { return false; }
+    m_entries[m_size].value = p;
+    m_entries[m_size].destroy = &teardown_list::delete_value<Global, T>;
+    ++m_size;
+    return true;
+  }
+
+  // Deleting a value may push more values
+  void drain() noexcept {
+    while (m_size) {
+      const entry e = m_entries[--m_size];
+      e.destroy(e.value);
+    }
+  }
+
+  // The list of the outermost destructor in this thread, if one is running
+  static teardown_list *& current() noexcept {
+    static thread_local teardown_list * instance = nullptr;
+    return instance;
+  }
+};
+
+template <typename Global, typename T>
+void
+delete_wrapped(T * p, std::false_type) noexcept {
+  detail::delete_node(p, Global{});
+}
+
+template <typename Global, typename T>
+void
+delete_wrapped(T * p, std::true_type) noexcept {
+  if (!p) { return; }
+
+  if (teardown_list * list = teardown_list::current()) {
+    if (!list->template push<Global>(p)) { detail::delete_node(p, Global{}); }
+    return;
+  }
+
+  teardown_list list;
+  teardown_list::current() = &list;
+  detail::delete_node(p, Global{});
+  list.drain();
+  teardown_list::current() = nullptr;
+}
+
+// Delete the value of a wrapper, iteratively if `T` opts in. `Global` says
+// whether it was allocated with `::new`, see `delete_node`.
+template <typename Global, typename T>
+void
+delete_wrapped(T * p) noexcept {
+  detail::delete_wrapped<Global>(p,
+                                 std::integral_constant<bool, iterative_destruction<T>::value>{});
+}
+
+} // end namespace detail
+
+} // end namespace strict_variant
@@ -0,0 +1,70 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Type-only visitation.
+ *
+ * Some visitors depend only on the type of the contained value, and not on
+ * the value itself -- e.g. a type name, a serialization tag, a size.
+ * For such a visitor, we evaluate it once for each alternative, at compile
+ * time, and put the results in a constant array indexed by `which`.
+ * Visiting is then just a load from that array, with no branches.
+ *
+ * A type-only visitor is a default-constructible type, with a `constexpr`
+ * call operator taking `type_tag<T>`, for each (unwrapped) type `T` of the
+ * variant. The results must be literal types.
+ */
+
+#include <strict_variant/variant.hpp>
+#include <strict_variant/wrapper.hpp>
+#include <type_traits>
+
+namespace strict_variant {
+
+//[ strict_variant_type_tag
+/***
+ * Empty object representing a type, passed to a type-only visitor.
+ */
+template <typename T>
+struct type_tag {
+  using type = T;
+};
+//]
+
+namespace detail {
+
+template <typename Visitor, typename Variant>
+struct type_table;
+
+template <typename Visitor, typename First, typename... Types>
+struct type_table<Visitor, variant<First, Types...>> {
+  using result_type = typename std::decay<typename std::common_type<
+    decltype(Visitor{}(type_tag<unwrap_type_t<First>>{})),
+    decltype(Visitor{}(type_tag<unwrap_type_t<Types>>{}))...>::type>::type;
+
+  static constexpr result_type values[1 + sizeof...(Types)] = {
+    Visitor{}(type_tag<unwrap_type_t<First>>{}), Visitor{}(type_tag<unwrap_type_t<Types>>{})...};
+};
+
+// Out-of-class definition, needed if the table is odr-used (C++11)
+template <typename Visitor, typename First, typename... Types>
+constexpr typename type_table<Visitor, variant<First, Types...>>::result_type
+  type_table<Visitor, variant<First, Types...>>::values[1 + sizeof...(Types)];
+
+} // end namespace detail
+
+/***
+ * Apply a type-only visitor to a variant. The result is looked up in a
+ * constant table.
+ */
+template <typename Visitor, typename First, typename... Types>
+inline typename detail::type_table<Visitor, variant<First, Types...>>::result_type
+apply_type_visitor(const variant<First, Types...> & v) noexcept {
+  return detail::type_table<Visitor, variant<First, Types...>>::values[v.which()];
+}
+
+} // end namespace strict_variant
@@ -20,6 +20,7 @@
  *   https://github.com/jarro2783/thenewcpp
  */
 
+#include <strict_variant/config.hpp>
 #include <strict_variant/filter_overloads.hpp>
 #include <strict_variant/mpl/find_with.hpp>
 #include <strict_variant/mpl/nonstd_traits.hpp>
@@ -27,12 +28,14 @@
 #include <strict_variant/mpl/typelist.hpp>
 #include <strict_variant/mpl/ulist.hpp>
 #include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/relocate.hpp>
 #include <strict_variant/safely_constructible.hpp>
 #include <strict_variant/variant_detail.hpp>
 #include <strict_variant/variant_dispatch.hpp>
 #include <strict_variant/variant_fwd.hpp>
 #include <strict_variant/variant_storage.hpp>
 
+#include <cstring>
 #include <type_traits>
 #include <utility>
 
@@ -58,6 +61,120 @@
 
 namespace strict_variant {
 
+namespace detail {
+
+struct storage_access;
+
+// Selects the constructors which copy or move the value of another variant
+struct from_variant_tag {};
+
+/***
+ * Holds the storage of a variant, and implements its destructor.
+ *
+ * If every type is trivially destructible, the destructor is trivial.
+ * Otherwise, it calls back into the variant. (This only touches the storage,
+ * since the variant is no longer alive at that point.)
+ */
+template <typename Variant, typename Storage, bool trivial>
+struct variant_destroy_base {
+  Storage m_storage;
+
+  // User-provided, so that value-initializing this base doesn't zero the storage
+  variant_destroy_base() noexcept {}
+
+  template <std::size_t index, typename... Args>
+  STRICT_VARIANT_CONSTEXPR14 variant_destroy_base(index_tag<index> tag, Args &&... args)
+    : m_storage(tag, std::forward<Args>(args)...) {}
+
+  variant_destroy_base(from_variant_tag, const Variant & rhs) {
+    Variant::copy_construct(m_storage, rhs);
+  }
+
+  variant_destroy_base(from_variant_tag, Variant && rhs) {
+    Variant::move_construct(m_storage, std::move(rhs));
+  }
+};
+
+template <typename Variant, typename Storage>
+struct variant_destroy_base<Variant, Storage, false> {
+  Storage m_storage;
+
+  variant_destroy_base() noexcept {}
+
+  template <std::size_t index, typename... Args>
+  variant_destroy_base(index_tag<index> tag, Args &&... args)
+    : m_storage(tag, std::forward<Args>(args)...) {}
+
+  // Copying or moving the value happens here, rather than in a derived
+  // constructor, so that if it throws, the destructor doesn't run on
+  // uninitialized storage.
+  variant_destroy_base(from_variant_tag, const Variant & rhs) {
+    Variant::copy_construct(m_storage, rhs);
+  }
+
+  variant_destroy_base(from_variant_tag, Variant && rhs) {
+    Variant::move_construct(m_storage, std::move(rhs));
+  }
+
+  variant_destroy_base(const variant_destroy_base &) = default;
+  variant_destroy_base(variant_destroy_base &&) = default;
+  variant_destroy_base & operator=(const variant_destroy_base &) = default;
+  variant_destroy_base & operator=(variant_destroy_base &&) = default;
+
+  ~variant_destroy_base() noexcept { Variant::destroy(m_storage); }
+};
+
+/***
+ * Implements the copy and move operations of a variant.
+ *
+ * If every type is trivially copyable, these are all trivial, so that the
+ * variant is trivially copyable, and a copy is just a copy of the storage and
+ * of `which`. Otherwise, they call back into the variant. (The construction
+ * code only touches the storage, since the variant is not alive yet.)
+ */
+template <typename Variant, typename Storage, typename Noexcept,
+          bool trivial = Noexcept::trivially_copyable>
+struct variant_base
+  : variant_destroy_base<Variant, Storage, Noexcept::trivially_destructible> {
+  variant_base() = default;
+
+  template <std::size_t index, typename... Args>
+  STRICT_VARIANT_CONSTEXPR14 variant_base(index_tag<index> tag, Args &&... args)
+    : variant_destroy_base<Variant, Storage, Noexcept::trivially_destructible>(
+        tag, std::forward<Args>(args)...) {}
+};
+
+template <typename Variant, typename Storage, typename Noexcept>
+struct variant_base<Variant, Storage, Noexcept, false>
+  : variant_destroy_base<Variant, Storage, Noexcept::trivially_destructible> {
+  using destroy_base_t = variant_destroy_base<Variant, Storage, Noexcept::trivially_destructible>;
+  using destroy_base_t::m_storage;
+
+  variant_base() = default;
+
+  template <std::size_t index, typename... Args>
+  variant_base(index_tag<index> tag, Args &&... args)
+    : destroy_base_t(tag, std::forward<Args>(args)...) {}
+
+  variant_base(const variant_base & rhs) noexcept(Noexcept::nothrow_copy_ctors)
+    : destroy_base_t(from_variant_tag{}, static_cast<const Variant &>(rhs)) {}
+
+  variant_base(variant_base && rhs) noexcept(Noexcept::nothrow_move_ctors)
+    : destroy_base_t(from_variant_tag{}, static_cast<Variant &&>(rhs)) {}
+
+  variant_base & operator=(const variant_base & rhs) noexcept(Noexcept::nothrow_copy_assign) {
+    static_cast<Variant &>(*this).copy_assign(static_cast<const Variant &>(rhs));
+    return *this;
+  }
+
+  variant_base & operator=(variant_base && rhs) noexcept(Noexcept::nothrow_move_assign) {
+    static_cast<Variant &>(*this).move_assign(static_cast<Variant &&>(rhs));
+    return *this;
+  }
+};
+
+} // end namespace detail
+
 /***
  * Trait to detect specializations of variant
  */
@@ -67,6 +184,32 @@ struct is_variant : std::false_type {};
 template <typename First, typename... Types>
 struct is_variant<variant<First, Types...>> : std::true_type {};
 
+// A variant is trivially relocatable if all of its types are
+template <typename First, typename... Types>
+struct is_trivially_relocatable<variant<First, Types...>>
+  : std::integral_constant<
+      bool, detail::variant_noexcept_helper<First, Types...>::trivially_relocatable> {};
+
+//[ strict_variant_discriminator_type
+/***
+ * Trait which selects the integer type used to store `which()` inside a
+ * variant. By default it is the smallest unsigned integer type which can hold
+ * every index. It may be specialized, e.g. to use `unsigned int` and get
+ * aligned tag accesses.
+ */
+template <typename Variant>
+struct discriminator_type;
+
+template <typename First, typename... Types>
+struct discriminator_type<variant<First, Types...>> {
+  static constexpr std::size_t num_types = 1 + sizeof...(Types);
+
+  using type = typename std::conditional<
+    (num_types <= 256u), unsigned char,
+    typename std::conditional<(num_types <= 65536u), unsigned short, unsigned int>::type>::type;
+};
+//]
+
 /***
  * Tag used in tag-dispatch with emplace-ctor
  */
@@ -77,7 +220,12 @@ struct emplace_tag {};
  * Class variant
  */
 template <typename First, typename... Types>
-class variant {
+class variant
+  : detail::variant_base<variant<First, Types...>,
+                         detail::discriminated_storage<
+                           detail::storage<First, Types...>,
+                           typename discriminator_type<variant<First, Types...>>::type>,
+                         detail::variant_noexcept_helper<First, Types...>> {
 
 private:
   /***
@@ -101,24 +249,79 @@ private:
    */
 
   using storage_t = detail::storage<First, Types...>;
-  storage_t m_storage;
 
-  int m_which;
+  using policy_t = typename dispatch_policy<variant>::type;
+
+  friend struct detail::storage_access;
+
+  using which_t = typename discriminator_type<variant>::type;
+
+  static_assert(std::is_integral<which_t>::value && std::is_unsigned<which_t>::value,
+                "discriminator_type must be an unsigned integer type");
+  static_assert(sizeof...(Types) <= static_cast<std::size_t>(static_cast<which_t>(-1)),
+                "discriminator_type is too small for this number of types");
+
+  // Holds `which` as well, either in a `which_t` member, or in the low bits of
+  // a pointer, if every type is a `recursive_wrapper`.
+  using discriminated_t = detail::discriminated_storage<storage_t, which_t>;
+
+  using noexcept_t = detail::variant_noexcept_helper<First, Types...>;
+  using base_t = detail::variant_base<variant, discriminated_t, noexcept_t>;
+  friend base_t;
+  friend detail::variant_destroy_base<variant, discriminated_t, noexcept_t::trivially_destructible>;
+
+  using base_t::m_storage;
 
   /***
    * Initialize and destroy
    */
-  void destroy() noexcept {
+  // If every type is trivially destructible, there is nothing to do
+  static void destroy(discriminated_t &, std::true_type) noexcept {}
+
+  static void destroy(discriminated_t & storage, std::false_type) noexcept {
     destroyer d;
-    this->apply_visitor_internal(d);
+    detail::visitor_dispatch<detail::true_, 1 + sizeof...(Types), policy_t>{}(
+      storage.which(), storage.payload(), d);
+  }
+
+  static void destroy(discriminated_t & storage) noexcept {
+    variant::destroy(storage, std::integral_constant<bool, noexcept_t::trivially_destructible>{});
   }
 
+  void destroy() noexcept { variant::destroy(m_storage); }
+
   template <std::size_t index, typename... Args>
   void initialize(Args &&... args) noexcept(
     noexcept(static_cast<storage_t *>(nullptr)->template initialize<index>(
       std::forward<Args>(std::declval<Args>())...))) {
     m_storage.template initialize<index>(std::forward<Args>(args)...);
-    this->m_which = static_cast<int>(index);
+  }
+
+  /***
+   * Non-trivial special member functions, called from variant_base
+   */
+  static void copy_construct(discriminated_t & storage, const variant & rhs);
+  static void move_construct(discriminated_t & storage, variant && rhs);
+  static void move_construct(discriminated_t & storage, variant && rhs, std::true_type) noexcept(
+    noexcept_t::nothrow_move_ctors);
+  static void move_construct(discriminated_t & storage, variant && rhs, std::false_type);
+  void copy_assign(const variant & rhs);
+  void move_assign(variant && rhs);
+
+  // Trivially relocatable: swap the bytes through a buffer
+  void swap_impl(variant & other, std::true_type) noexcept {
+    if (this != &other) {
+      alignas(discriminated_t) unsigned char buffer[sizeof(discriminated_t)];
+      std::memcpy(buffer, static_cast<const void *>(&m_storage), sizeof(discriminated_t));
+      std::memcpy(static_cast<void *>(&m_storage), static_cast<const void *>(&other.m_storage),
+                  sizeof(discriminated_t));
+      std::memcpy(static_cast<void *>(&other.m_storage), buffer, sizeof(discriminated_t));
+    }
+  }
+
+  void swap_impl(variant & other, std::false_type) noexcept {
+    swapper s{*this, other};
+    s.do_swap();
   }
 
   /***
@@ -139,8 +342,9 @@ private:
     // recursive_wrapper.
     // 2) Must change type, but initializing the new value is noexcept. Can destroy and do it
     // directly.
-    // 3) Must change type, and initializing the new value may throw. Do it on the stack, and then
-    // move into storage.
+    // 3) Must change type, and initializing the new value may throw. If the old and new types
+    // are `recursive_wrapper` and the allocation can be reused, do that. Otherwise do it on the
+    // stack, and then move into storage.
 
     static_assert(noexcept(this->destroy()), "Noexcept assumption failed!");
 
@@ -149,7 +353,7 @@ private:
     } else if (assume_nothrow_init || noexcept(this->initialize<index>(std::forward<Rhs>(rhs)))) {
       this->destroy();
       this->initialize<index>(std::forward<Rhs>(rhs));
-    } else {
+    } else if (!this->reuse_wrapper<index>(std::forward<Rhs>(rhs))) {
       static_assert(detail::variant_noexcept_helper<First, Types...>::assume_move_nothrow
                       || noexcept(this->initialize<index>(std::declval<temp_t>())),
                     "Noexcept assumption failed!");
@@ -160,6 +364,66 @@ private:
     }
   }
 
+  /***
+   * Heap node reuse
+   * If we hold a `recursive_wrapper`, and the new value goes in a
+   * `recursive_wrapper` of a type with the same size and alignment, construct
+   * the new value in the old allocation. Returns false if this isn't possible,
+   * and then the arguments are not used.
+   *
+   * The arguments may refer into the old value, so the new value is always
+   * constructed on the stack first, and then moved into the old allocation.
+   */
+  template <typename To>
+  struct reuse_checker;
+  template <typename To>
+  struct reclaimer;
+
+  // 0: Not possible, 1: Possible, and constructing the value is noexcept, 2: Possible
+  template <std::size_t index, typename... Args>
+  struct reuse_mode {
+    using temp_t = typename storage_t::template value_t<index>;
+    using value_type = unwrap_type_t<temp_t>;
+
+    static constexpr bool possible =
+      std::is_nothrow_move_constructible<value_type>::value
+      && mpl::Find_Any<detail::wrapper_reuse::compatible_with<temp_t>::template prop, First,
+                       Types...>::value;
+
+    static constexpr int value =
+      !possible ? 0 : std::is_nothrow_constructible<value_type, Args...>::value ? 1 : 2;
+  };
+
+  template <std::size_t index, typename... Args>
+  bool reuse_wrapper(Args &&... args) noexcept(reuse_mode<index, Args...>::value != 2) {
+    return this->reuse_wrapper_impl<index>(
+      std::integral_constant<bool, reuse_mode<index, Args...>::value != 0>{},
+      std::forward<Args>(args)...);
+  }
+
+  template <std::size_t index, typename... Args>
+  bool reuse_wrapper_impl(std::false_type, Args &&...) noexcept {
+    return false;
+  }
+
+  template <std::size_t index, typename... Args>
+  bool reuse_wrapper_impl(std::true_type, Args &&... args) noexcept(
+    reuse_mode<index, Args...>::value != 2);
+
+  /***
+   * Type-changing copy assignment from a wrapper. The wrapper is copied by
+   * its copy constructor, so that e.g. it can propagate its allocator.
+   */
+  template <std::size_t index, typename W>
+  void copy_assign_wrapper(const W & w);
+
+  /***
+   * Move assignment from a `recursive_wrapper`, by taking its pointer, when
+   * there is a `blank` to leave in the source
+   */
+  template <std::size_t index>
+  void steal_assign(variant & rhs) noexcept;
+
   /***
    * Used for internal visitors
    */
@@ -168,8 +432,14 @@ private:
     // Implementation note:
     // `detail::true_` here indicates that the visit is internal and we should
     // NOT pierce `recursive_wrapper`.
-    return detail::visitor_dispatch<detail::true_, 1 + sizeof...(Types)>{}(static_cast<unsigned>(m_which), m_storage,
-                                                                           visitor);
+    return detail::visitor_dispatch<detail::true_, 1 + sizeof...(Types), policy_t>{}(
+      m_storage.which(), m_storage.payload(), visitor);
+  }
+
+  template <typename Visitor>
+  auto apply_visitor_internal(Visitor & visitor) const -> typename Visitor::result_type {
+    return detail::visitor_dispatch<detail::true_, 1 + sizeof...(Types), policy_t>{}(
+      m_storage.which(), m_storage.payload(), visitor);
   }
 
   /***
@@ -190,6 +460,10 @@ private:
   struct constructor;
   struct assigner;
   struct destroyer;
+  struct copy_assigner;
+  struct move_assigner;
+  struct stealer;
+  struct value_mover;
   struct swapper;
 
   /***
@@ -249,7 +523,7 @@ private:
   }
 
 public:
-  ~variant() noexcept { this->destroy(); }
+  ~variant() = default;
 
   // Constructors
   // Note: We use detail:: instead of std:: for trait because we handle
@@ -257,20 +531,20 @@ public:
   // TODO: It would be nice if we actually SFINAED the definitions of these
   // special member functions, following akrzemi1's technical description:
   // https://akrzemi1.wordpress.com/2015/03/02/a-conditional-copy-constructor/
-  variant() noexcept(detail::is_nothrow_default_constructible<First>::value);
-
-  variant(const variant & rhs) noexcept(
-    detail::variant_noexcept_helper<First, Types...>::nothrow_copy_ctors);
+  STRICT_VARIANT_CONSTEXPR14 variant() noexcept(
+    detail::is_nothrow_default_constructible<First>::value);
 
-  variant(variant && rhs) noexcept(
-    detail::variant_noexcept_helper<First, Types...>::nothrow_move_ctors);
+  // Copy and move are trivial if every type is trivially copyable.
+  // The destructor is trivial if every type is trivially destructible.
+  variant(const variant &) = default;
+  variant(variant &&) = default;
 
   /// Forwarding-reference ctor, construct a variant from one of its value
   /// types, using overload resolution. See documentation.
   template <typename T,
             typename =
               mpl::enable_if_t<!is_variant<mpl::remove_const_t<mpl::remove_reference_t<T>>>::value>>
-  variant(T && t);
+  STRICT_VARIANT_CONSTEXPR14 variant(T && t);
 
   /// "Generalizing Ctor"
   /// Allow constructing from a variant over a subset of our types
@@ -287,24 +561,21 @@ public:
             typename Enable = mpl::enable_if_t<detail::proper_subvariant<variant<OFirst, OTypes...>,
                                                                          variant>::value>>
   variant(variant<OFirst, OTypes...> && other) noexcept(
-    detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_move_ctors);
+    detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_value_move_ctors);
 
   // Emplace ctor. Used to explicitly specify the type of the variant, and
   // invoke an arbitrary ctor of that type.
   template <typename T, typename... Args>
-  explicit variant(emplace_tag<T>,
-                   Args &&... args) noexcept(std::is_nothrow_constructible<T, Args...>::value);
+  STRICT_VARIANT_CONSTEXPR14 explicit variant(emplace_tag<T>, Args &&... args) noexcept(
+    std::is_nothrow_constructible<T, Args...>::value);
 
   /***
    * Modifiers
    */
 
   // Assignment
-  variant & operator=(const variant & rhs) noexcept(
-    detail::variant_noexcept_helper<First, Types...>::nothrow_copy_assign);
-
-  variant & operator=(variant && rhs) noexcept(
-    detail::variant_noexcept_helper<First, Types...>::nothrow_move_assign);
+  variant & operator=(const variant &) = default;
+  variant & operator=(variant &&) = default;
 
   // Forwarding reference assignment
   template <typename T,
@@ -323,7 +594,7 @@ public:
             typename Enable = mpl::enable_if_t<detail::proper_subvariant<variant<OFirst, OTypes...>,
                                                                          variant>::value>>
   variant & operator=(variant<OFirst, OTypes...> && other) noexcept(
-    detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_move_assign);
+    detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_value_move_assign);
 
   // Emplace operation
   template <std::size_t index, typename... Args>
@@ -348,18 +619,19 @@ public:
   }
 
   // Swap operation
-  // Optimized in case of `recursive_wrapper` to use a pointer move.
+  // Optimized in case of trivially relocatable types (including
+  // `recursive_wrapper`) to swap the bytes.
   void swap(variant & other) noexcept;
 
   /***
    * Accessors
    */
 
-  int which() const noexcept { return m_which; }
+  constexpr int which() const noexcept { return static_cast<int>(m_storage.which()); }
 
   // get
   template <typename T>
-  T * get() noexcept {
+  STRICT_VARIANT_CONSTEXPR14 T * get() noexcept {
     constexpr std::size_t idx = find_which<T>::value;
     static_assert(idx < sizeof...(Types) + 1,
                   "Requested type is not a member of this variant type");
@@ -368,7 +640,7 @@ public:
   }
 
   template <typename T>
-  const T * get() const noexcept {
+  STRICT_VARIANT_CONSTEXPR14 const T * get() const noexcept {
     constexpr std::size_t idx = find_which<T>::value;
     static_assert(idx < sizeof...(Types) + 1,
                   "Requested type is not a member of this variant type");
@@ -378,9 +650,9 @@ public:
 
   // get with integer index
   template <std::size_t idx>
-  auto get() noexcept
+  STRICT_VARIANT_CONSTEXPR14 auto get() noexcept
     -> decltype(&static_cast<storage_t *>(nullptr)->template get_value<idx>(detail::false_{})) {
-    if (idx == m_which) {
+    if (idx == m_storage.which()) {
       return &m_storage.template get_value<idx>(detail::false_{});
     } else {
       return nullptr;
@@ -388,9 +660,9 @@ public:
   }
 
   template <std::size_t idx>
-  auto get() const noexcept -> decltype(
+  STRICT_VARIANT_CONSTEXPR14 auto get() const noexcept -> decltype(
     &static_cast<const storage_t *>(nullptr)->template get_value<idx>(detail::false_{})) {
-    if (idx == m_which) {
+    if (idx == m_storage.which()) {
       return &m_storage.template get_value<idx>(detail::false_{});
     } else {
       return nullptr;
@@ -403,42 +675,61 @@ public:
 
   // Implementation details for apply_visitor
   // private:
-  using dispatcher_t = detail::visitor_dispatch<detail::false_, 1 + sizeof...(Types)>;
+  using dispatcher_t = detail::visitor_dispatch<detail::false_, 1 + sizeof...(Types), policy_t>;
 
 #define APPLY_VISITOR_IMPL_BODY                                                                    \
-  dispatcher_t{}(static_cast<unsigned>(visitable.which()), std::forward<Visitable>(visitable).m_storage,                  \
+  dispatcher_t{}(static_cast<unsigned>(visitable.which()),                                         \
+                 std::forward<Visitable>(visitable).m_storage.payload(),                           \
                  std::forward<Visitor>(visitor))
 
   // Visitable is assumed to be, forwarding reference to this type.
   template <typename Visitor, typename Visitable>
-  static auto apply_visitor_impl(Visitor && visitor,
-                                 Visitable && visitable) noexcept(noexcept(APPLY_VISITOR_IMPL_BODY))
+  static STRICT_VARIANT_CONSTEXPR14 auto
+  apply_visitor_impl(Visitor && visitor,
+                     Visitable && visitable) noexcept(noexcept(APPLY_VISITOR_IMPL_BODY))
     -> decltype(APPLY_VISITOR_IMPL_BODY) {
     static_assert(std::is_same<const variant, const mpl::remove_reference_t<Visitable>>::value,
                   "Misuse of apply_visitor_impl!");
     return APPLY_VISITOR_IMPL_BODY;
   }
 
+#undef APPLY_VISITOR_IMPL_BODY
+
+#define APPLY_VISITOR_IMPL_BODY                                                                    \
+  detail::visitor_dispatch<detail::false_, 1 + sizeof...(Types), Policy>{}(                        \
+    static_cast<unsigned>(visitable.which()),                                                      \
+    std::forward<Visitable>(visitable).m_storage.payload(), std::forward<Visitor>(visitor))
+
+  // Same as above, but the dispatch policy is chosen by the caller
+  template <typename Policy, typename Visitor, typename Visitable>
+  static STRICT_VARIANT_CONSTEXPR14 auto
+  apply_visitor_with_impl(Visitor && visitor, Visitable && visitable) noexcept(
+    noexcept(APPLY_VISITOR_IMPL_BODY)) -> decltype(APPLY_VISITOR_IMPL_BODY) {
+    static_assert(std::is_same<const variant, const mpl::remove_reference_t<Visitable>>::value,
+                  "Misuse of apply_visitor_with_impl!");
+    return APPLY_VISITOR_IMPL_BODY;
+  }
+
 #undef APPLY_VISITOR_IMPL_BODY
 
   // public:
   // C++17 visit syntax
   template <typename V>
-    auto visit(V && v)
+  STRICT_VARIANT_CONSTEXPR14 auto visit(V && v)
     & noexcept(noexcept(apply_visitor_impl(std::forward<V>(v), *static_cast<variant *>(nullptr))))
         -> decltype(apply_visitor_impl(std::forward<V>(v), *this)) {
     return apply_visitor_impl(std::forward<V>(v), *this);
   }
 
   template <typename V>
-  auto visit(V && v) const & noexcept(
+  STRICT_VARIANT_CONSTEXPR14 auto visit(V && v) const & noexcept(
     noexcept(apply_visitor_impl(std::forward<V>(v), *static_cast<const variant *>(nullptr))))
     -> decltype(apply_visitor_impl(std::forward<V>(v), *this)) {
     return apply_visitor_impl(std::forward<V>(v), *this);
   }
 
   template <typename V>
-    auto visit(V && v)
+  STRICT_VARIANT_CONSTEXPR14 auto visit(V && v)
     && noexcept(noexcept(apply_visitor_impl(std::forward<V>(v),
                                             std::move(*static_cast<variant *>(nullptr)))))
          -> decltype(apply_visitor_impl(std::forward<V>(v), std::move(*this))) {
@@ -446,6 +737,34 @@ public:
   }
 };
 
+namespace detail {
+
+/***
+ * Gives other parts of the library direct access to the storage of a variant,
+ * e.g. to implement dispatch over more than one variant.
+ */
+struct storage_access {
+  template <typename Visitable>
+  static auto get(Visitable && visitable) noexcept
+    -> decltype(std::forward<Visitable>(visitable).m_storage.payload()) {
+    return std::forward<Visitable>(visitable).m_storage.payload();
+  }
+};
+
+// Number of alternatives of a variant type
+template <typename V>
+struct variant_num_types;
+
+template <typename First, typename... Types>
+struct variant_num_types<variant<First, Types...>> {
+  static constexpr unsigned value = 1 + sizeof...(Types);
+};
+
+template <typename V>
+struct variant_num_types<const V> : variant_num_types<V> {};
+
+} // end namespace detail
+
 /***
  * apply one visitor function. `boost::variant` syntax.
  * This is the basic version, used in implementation of multivisitation.
@@ -454,7 +773,7 @@ public:
   mpl::remove_reference_t<Visitable>::apply_visitor_impl(std::forward<Visitor>(visitor),           \
                                                          std::forward<Visitable>(visitable))
 template <typename Visitor, typename Visitable>
-auto
+STRICT_VARIANT_CONSTEXPR14 auto
 apply_visitor(Visitor && visitor, Visitable && visitable) noexcept(noexcept(APPLY_VISITOR_BODY))
   -> decltype(APPLY_VISITOR_BODY) {
   return APPLY_VISITOR_BODY;
@@ -462,31 +781,50 @@ apply_visitor(Visitor && visitor, Visitable && visitable) noexcept(noexcept(APPL
 
 #undef APPLY_VISITOR_BODY
 
+/***
+ * apply one visitor function, using the given dispatch policy rather than the
+ * one selected by `dispatch_policy` for this variant type.
+ * For instance, to hint at the likely types at a particular call site:
+ *   apply_visitor_with<dispatch::likely<dispatch::default_policy, 0>>(vis, var)
+ */
+#define APPLY_VISITOR_BODY                                                                         \
+  mpl::remove_reference_t<Visitable>::template apply_visitor_with_impl<Policy>(                    \
+    std::forward<Visitor>(visitor), std::forward<Visitable>(visitable))
+template <typename Policy, typename Visitor, typename Visitable>
+STRICT_VARIANT_CONSTEXPR14 auto
+apply_visitor_with(Visitor && visitor,
+                   Visitable && visitable) noexcept(noexcept(APPLY_VISITOR_BODY))
+  -> decltype(APPLY_VISITOR_BODY) {
+  return APPLY_VISITOR_BODY;
+}
+
+#undef APPLY_VISITOR_BODY
+
 /***
  * strict_variant::get function (same semantics as boost::get with pointer type)
  */
 template <typename T, typename... Types>
-T *
+STRICT_VARIANT_CONSTEXPR14 T *
 get(variant<Types...> * var) noexcept {
   return var->template get<T>();
 }
 
 template <typename T, typename... Types>
-const T *
+STRICT_VARIANT_CONSTEXPR14 const T *
 get(const variant<Types...> * var) noexcept {
   return var->template get<T>();
 }
 
 // Using integer index
 template <std::size_t idx, typename... Types>
-auto
+STRICT_VARIANT_CONSTEXPR14 auto
 get(variant<Types...> * var) noexcept
   -> decltype(static_cast<variant<Types...> *>(nullptr)->template get<idx>()) {
   return var->template get<idx>();
 }
 
 template <std::size_t idx, typename... Types>
-auto
+STRICT_VARIANT_CONSTEXPR14 auto
 get(const variant<Types...> * var) noexcept
   -> decltype(static_cast<const variant<Types...> *>(nullptr)->template get<idx>()) {
   return var->template get<idx>();
@@ -510,6 +848,7 @@ get_or_default(variant<Types...> & v,
 
 /***
  * Trait to add the wrapper if a type is not no-throw move constructible
+ * (The type must be complete to check this, so `heap_wrapper` is used.)
  */
 
 //[ strict_variant_wrap_if_throwing_move
@@ -517,7 +856,7 @@ template <typename T, typename = mpl::enable_if_t<std::is_nothrow_destructible<T
                                                   && !std::is_reference<T>::value>>
 struct wrap_if_throwing_move {
   using type = typename std::conditional<std::is_nothrow_move_constructible<T>::value, T,
-                                         recursive_wrapper<T>>::type;
+                                         heap_wrapper<T>>::type;
 };
 
 template <typename T>
@@ -529,6 +868,28 @@ template <typename... Ts>
 using easy_variant = variant<wrap_if_throwing_move_t<Ts>...>;
 //]
 
+/***
+ * Trait to add the wrapper if a type is larger than a budget, in bytes
+ * (The type must be complete to check this, so `heap_wrapper` is used.)
+ */
+
+//[ strict_variant_wrap_if_larger_than
+template <std::size_t Budget, typename T,
+          typename = mpl::enable_if_t<std::is_nothrow_destructible<T>::value
+                                      && !std::is_reference<T>::value>>
+struct wrap_if_larger_than {
+  using type = typename std::conditional<(sizeof(T) > Budget), heap_wrapper<T>, T>::type;
+};
+
+template <std::size_t Budget, typename T>
+using wrap_if_larger_than_t = typename wrap_if_larger_than<Budget, T>::type;
+//]
+
+//[ strict_variant_compact_variant
+template <std::size_t Budget, typename... Ts>
+using compact_variant = variant<wrap_if_larger_than_t<Budget, Ts>...>;
+//]
+
 /***
  * Implementation details of private visitors
  */
@@ -536,17 +897,17 @@ template <typename First, typename... Types>
 struct variant<First, Types...>::constructor {
   typedef void result_type;
 
-  explicit constructor(variant & self)
-    : m_self(self) {}
+  explicit constructor(discriminated_t & storage)
+    : m_storage(storage) {}
 
   template <typename T>
   void operator()(T && rhs) const {
     constexpr std::size_t index = find_which<mpl::remove_reference_t<T>>::value;
-    m_self.template initialize<index>(std::forward<T>(rhs));
+    m_storage.template initialize<index>(std::forward<T>(rhs));
   }
 
 private:
-  variant & m_self;
+  discriminated_t & m_storage;
 };
 
 // assigner
@@ -581,6 +942,160 @@ struct variant<First, Types...>::destroyer {
   }
 };
 
+// copy_assigner
+// Visits the (non-pierced) value of the source of a copy assignment. A wrapper
+// of the type the target already holds is assigned by assigning the values,
+// otherwise it is copied, see `copy_assign_wrapper`. Other values are assigned
+// as usual.
+template <typename First, typename... Types>
+struct variant<First, Types...>::copy_assigner {
+  typedef void result_type;
+
+  static_assert(detail::variant_noexcept_helper<First, Types...>::assignable,
+                "All types in this variant must be nothrow move constructible or placed in a "
+                "recursive_wrapper, or the variant cannot be assigned!");
+
+  explicit copy_assigner(variant & self)
+    : m_self(self) {}
+
+  template <typename T>
+  void operator()(const T & t) const {
+    constexpr std::size_t index = find_which<T>::value;
+    this->copy_assign<index>(t, std::integral_constant<bool, detail::is_wrapper<T>::value>{});
+  }
+
+private:
+  template <std::size_t index, typename T>
+  void copy_assign(const T & t, std::false_type) const {
+    m_self.template assign<index>(t);
+  }
+
+  template <std::size_t index, typename T>
+  void copy_assign(const T & t, std::true_type) const {
+    if (m_self.which() == index) {
+      m_self.m_storage.template get_value<index>(detail::false_{}) = t.get();
+    } else {
+      m_self.template copy_assign_wrapper<index>(t);
+    }
+  }
+
+  variant & m_self;
+};
+
+// move_assigner
+// Visits the (non-pierced) value of the source of a move assignment. A
+// `recursive_wrapper` is moved by taking its pointer, other values are
+// assigned as usual.
+template <typename First, typename... Types>
+struct variant<First, Types...>::move_assigner {
+  typedef void result_type;
+
+  static_assert(detail::variant_noexcept_helper<First, Types...>::assignable,
+                "All types in this variant must be nothrow move constructible or placed in a "
+                "recursive_wrapper, or the variant cannot be assigned!");
+
+  move_assigner(variant & self, variant & source)
+    : m_self(self)
+    , m_source(source) {}
+
+  template <typename T>
+  void operator()(T & t) const {
+    constexpr std::size_t index = find_which<T>::value;
+    this->move_assign<index>(t, std::integral_constant<bool, detail::is_wrapper<T>::value>{});
+  }
+
+private:
+  template <std::size_t index, typename T>
+  void move_assign(T & t, std::false_type) const {
+    this->assign_value<index>(std::move(t));
+  }
+
+  template <std::size_t index, typename T>
+  void move_assign(T & t, std::true_type) const {
+    this->move_assign_wrapper<index>(t, std::integral_constant<bool, noexcept_t::has_blank>{});
+  }
+
+  template <std::size_t index, typename T>
+  void move_assign_wrapper(T &, std::true_type) const noexcept {
+    m_self.template steal_assign<index>(m_source);
+  }
+
+  // Without `blank`, the source would have to be left holding the old value of
+  // the target. But the source may be part of that value, e.g. in
+  // `e = std::move(get<node>(&e)->child)`, and then the value would own
+  // itself. So the value is moved out of the wrapper instead, as it is by the
+  // other move operations.
+  template <std::size_t index, typename T>
+  void move_assign_wrapper(T & t, std::false_type) const {
+    this->assign_value<index>(std::move(t).get());
+  }
+
+  // Destroying the old value of the target may also destroy the source, as in
+  // the example above, so when the type changes, the value is moved to the
+  // stack first.
+  template <std::size_t index, typename V>
+  void assign_value(V && v) const {
+    if (m_self.which() == index) {
+      m_self.template assign<index>(std::move(v));
+    } else {
+      mpl::remove_const_t<mpl::remove_reference_t<V>> value(std::move(v));
+      m_self.template assign<index>(std::move(value));
+    }
+  }
+
+  variant & m_self;
+  variant & m_source;
+};
+
+// stealer
+// Move constructs from the (non-pierced) value of a variant which has `blank`
+// as one of its types. A `recursive_wrapper` is moved by taking its pointer,
+// and then the source is left holding `blank`.
+template <typename First, typename... Types>
+struct variant<First, Types...>::stealer {
+  typedef void result_type;
+
+  stealer(discriminated_t & storage, discriminated_t & source)
+    : m_storage(storage)
+    , m_source(source) {}
+
+  template <typename T>
+  void operator()(T & t) const noexcept(std::is_nothrow_move_constructible<T>::value) {
+    constexpr std::size_t index = find_which<T>::value;
+    m_storage.template initialize<index>(std::move(t));
+
+    if (detail::is_wrapper<T>::value) {
+      t.~T();
+      m_source.template initialize<find_which<blank>::value>();
+    }
+  }
+
+private:
+  discriminated_t & m_storage;
+  discriminated_t & m_source;
+};
+
+// value_mover
+// Move constructs from the (non-pierced) value of a variant. A wrapper is not
+// moved by taking its pointer, instead its value is moved into a new wrapper,
+// (using the same allocator, if it has one).
+template <typename First, typename... Types>
+struct variant<First, Types...>::value_mover {
+  typedef void result_type;
+
+  explicit value_mover(discriminated_t & storage)
+    : m_storage(storage) {}
+
+  template <typename T>
+  void operator()(T & t) const {
+    constexpr std::size_t index = find_which<T>::value;
+    detail::wrapper_value_mover<T>::template move_value<index>(m_storage, t);
+  }
+
+private:
+  discriminated_t & m_storage;
+};
+
 /***
  * Implementation details of ctors
  */
@@ -590,66 +1105,119 @@ struct variant<First, Types...>::destroyer {
                         "Postcondition failed!")
 
 template <typename First, typename... Types>
+STRICT_VARIANT_CONSTEXPR14
 variant<First, Types...>::variant() noexcept(
-  detail::is_nothrow_default_constructible<First>::value) {
+  detail::is_nothrow_default_constructible<First>::value)
+  : base_t(detail::index_tag<0>{}) {
   static_assert(std::is_default_constructible<First>::value,
                 "First type must be default constructible or variant is not!");
-  this->initialize<0>();
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
 }
 
 // Special member functions
+// (These are used only if some type is not trivially copyable.)
 template <typename First, typename... Types>
-variant<First, Types...>::variant(const variant & rhs) noexcept(
-  detail::variant_noexcept_helper<First, Types...>::nothrow_copy_ctors) {
-  constructor c(*this);
-  apply_visitor(c, rhs);
-  STRICT_VARIANT_ASSERT(rhs.which() == this->which(), "Postcondition failed!");
-  STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
+void
+variant<First, Types...>::copy_construct(discriminated_t & storage, const variant & rhs) {
+  // Don't pierce, so that a wrapper is copied by its copy constructor, and can
+  // e.g. propagate its allocator
+  constructor c(storage);
+  rhs.apply_visitor_internal(c);
+  STRICT_VARIANT_ASSERT(rhs.which() == static_cast<int>(storage.which()), "Postcondition failed!");
 }
 
-// Note: noexcept is enforced by static_assert in move_constructor visitor
 template <typename First, typename... Types>
-variant<First, Types...>::variant(variant && rhs) noexcept(
-  detail::variant_noexcept_helper<First, Types...>::nothrow_move_ctors) {
-  constructor mc(*this);
-  apply_visitor(mc, std::move(rhs));
-  STRICT_VARIANT_ASSERT(rhs.which() == this->which(), "Postcondition failed!");
-  STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
+void
+variant<First, Types...>::move_construct(discriminated_t & storage, variant && rhs) {
+  variant::move_construct(storage, std::move(rhs),
+                          std::integral_constant<bool, noexcept_t::has_blank>{});
 }
 
+// If there is a `blank` type, steal the pointer of a `recursive_wrapper`
 template <typename First, typename... Types>
-variant<First, Types...> &
-variant<First, Types...>::operator=(const variant & rhs) noexcept(
-  detail::variant_noexcept_helper<First, Types...>::nothrow_copy_assign) {
-  assigner a(*this);
-  apply_visitor(a, rhs);
+void
+variant<First, Types...>::move_construct(discriminated_t & storage, variant && rhs,
+                                         std::true_type) noexcept(noexcept_t::nothrow_move_ctors) {
+  stealer s(storage, rhs.m_storage);
+  rhs.apply_visitor_internal(s);
+}
+
+// Otherwise, pierce the `recursive_wrapper`, and move the value
+template <typename First, typename... Types>
+void
+variant<First, Types...>::move_construct(discriminated_t & storage, variant && rhs,
+                                         std::false_type) {
+  value_mover mc(storage);
+  rhs.apply_visitor_internal(mc);
+  STRICT_VARIANT_ASSERT(rhs.which() == static_cast<int>(storage.which()), "Postcondition failed!");
+}
+
+// Note: We don't pierce the wrapper here either, so that it can e.g.
+// propagate its allocator, see `copy_assign_wrapper`.
+template <typename First, typename... Types>
+void
+variant<First, Types...>::copy_assign(const variant & rhs) {
+  copy_assigner a(*this);
+  rhs.apply_visitor_internal(a);
   STRICT_VARIANT_ASSERT(rhs.which() == this->which(), "Postcondition failed!");
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
-  return *this;
 }
 
-// Note: We want to pierce the recursive_wrapper here, if we move it then
+// Note: We don't pierce the recursive_wrapper here, so that it can be moved
+// by taking its pointer, see `steal_assign`.
 template <typename First, typename... Types>
-variant<First, Types...> &
-variant<First, Types...>::operator=(variant && rhs) noexcept(
-  detail::variant_noexcept_helper<First, Types...>::nothrow_move_assign) {
-  assigner ma(*this);
-  apply_visitor(ma, std::move(rhs));
-  STRICT_VARIANT_ASSERT(rhs.which() == this->which(), "Postcondition failed!");
+void
+variant<First, Types...>::move_assign(variant && rhs) {
+  if (this != &rhs) {
+    move_assigner ma(*this, rhs);
+    rhs.apply_visitor_internal(ma);
+  }
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
-  return *this;
+}
+
+// The heap node can only be reused if the wrapper has no allocator, and then
+// copying the wrapper is the same as copying its value. The copy is always
+// made before the old value is destroyed, since `w` may be part of it.
+template <typename First, typename... Types>
+template <std::size_t index, typename W>
+void
+variant<First, Types...>::copy_assign_wrapper(const W & w) {
+  using temp_t = typename storage_t::template value_t<index>;
+  static_assert(std::is_same<temp_t, W>::value, "Bad index in copy assignment!");
+
+  if (this->reuse_wrapper<index>(w.get())) { return; }
+
+  static_assert(detail::variant_noexcept_helper<First, Types...>::assume_move_nothrow
+                  || noexcept(this->initialize<index>(std::declval<temp_t>())),
+                "Noexcept assumption failed!");
+
+  temp_t tmp(w);                           // may throw
+  this->destroy();                         // nothrow
+  this->initialize<index>(std::move(tmp)); // nothrow
+}
+
+// The source is left holding `blank`.
+template <typename First, typename... Types>
+template <std::size_t index>
+void
+variant<First, Types...>::steal_assign(variant & rhs) noexcept {
+  using temp_t = typename storage_t::template value_t<index>;
+
+  temp_t tmp(std::move(rhs.m_storage.template get_value<index>(detail::true_{})));
+  rhs.destroy();
+  rhs.template initialize<find_which<blank>::value>();
+  this->destroy();
+  this->initialize<index>(std::move(tmp));
 }
 
 /// Forwarding-reference ctor
 template <typename First, typename... Types>
 template <typename T, typename>
-variant<First, Types...>::variant(T && t) {
+STRICT_VARIANT_CONSTEXPR14 variant<First, Types...>::variant(T && t)
+  : base_t(detail::index_tag<initializer_slot<T>()>{}, std::forward<T>(t)) {
   static_assert(!std::is_same<variant &, mpl::remove_const_t<T>>::value,
                 "why is variant(T&&) instantiated with a variant? why was a special "
                 "member function not selected?");
-  constexpr unsigned idx = initializer_slot<T>();
-  this->initialize<idx>(std::forward<T>(t));
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
 }
 
@@ -672,7 +1240,7 @@ template <typename First, typename... Types>
 template <typename OFirst, typename... OTypes, typename Enable>
 variant<First, Types...>::variant(const variant<OFirst, OTypes...> & other) noexcept(
   detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_copy_ctors) {
-  constructor c(*this);
+  constructor c(m_storage);
   apply_visitor(c, other);
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
 }
@@ -681,8 +1249,8 @@ variant<First, Types...>::variant(const variant<OFirst, OTypes...> & other) noex
 template <typename First, typename... Types>
 template <typename OFirst, typename... OTypes, typename Enable>
 variant<First, Types...>::variant(variant<OFirst, OTypes...> && other) noexcept(
-  detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_move_ctors) {
-  constructor c(*this);
+  detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_value_move_ctors) {
+  constructor c(m_storage);
   apply_visitor(c, std::move(other));
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
 }
@@ -703,7 +1271,7 @@ template <typename First, typename... Types>
 template <typename OFirst, typename... OTypes, typename Enable>
 variant<First, Types...> &
 variant<First, Types...>::operator=(variant<OFirst, OTypes...> && other) noexcept(
-  detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_move_assign) {
+  detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_value_move_assign) {
   assigner a(*this);
   apply_visitor(a, std::move(other));
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
@@ -714,12 +1282,12 @@ variant<First, Types...>::operator=(variant<OFirst, OTypes...> && other) noexcep
 // invoke an arbitrary ctor of that type.
 template <typename First, typename... Types>
 template <typename T, typename... Args>
-variant<First, Types...>::variant(emplace_tag<T>, Args &&... args) noexcept(
-  std::is_nothrow_constructible<T, Args...>::value) {
-  constexpr std::size_t idx = find_which<T>::value;
-  static_assert(idx < sizeof...(Types) + 1, "Requested type is not a member of this variant type");
-
-  this->initialize<idx>(std::forward<Args>(args)...);
+STRICT_VARIANT_CONSTEXPR14 variant<First, Types...>::variant(emplace_tag<T>,
+                                                             Args &&... args) noexcept(
+  std::is_nothrow_constructible<T, Args...>::value)
+  : base_t(detail::index_tag<find_which<T>::value>{}, std::forward<Args>(args)...) {
+  static_assert(find_which<T>::value < sizeof...(Types) + 1,
+                "Requested type is not a member of this variant type");
 }
 
 // Emplace operation
@@ -740,6 +1308,7 @@ variant<First, Types...>::emplace(Args &&... args) noexcept(false)
   static_assert(
     std::is_nothrow_move_constructible<temp_t>::value,
     "To use emplace, either the invoked ctor or the move ctor of value type must be noexcept.");
+  if (this->reuse_wrapper<idx>(std::forward<Args>(args)...)) { return; }
   temp_t temp(std::forward<Args>(args)...);
   this->emplace<idx>(std::move(temp));
 }
@@ -758,10 +1327,59 @@ variant<First, Types...>::emplace(Args &&... args) noexcept
   this->initialize<idx>(std::forward<Args>(args)...);
 }
 
+// Heap node reuse
+
+template <typename First, typename... Types>
+template <typename To>
+struct variant<First, Types...>::reuse_checker {
+  typedef bool result_type;
+
+  template <typename T>
+  bool operator()(T &) const noexcept {
+    return detail::wrapper_reuse::compatible<T, To>::value;
+  }
+};
+
+template <typename First, typename... Types>
+template <typename To>
+struct variant<First, Types...>::reclaimer {
+  typedef void * result_type;
+
+  template <typename T>
+  void * operator()(T & t) const noexcept {
+    return detail::wrapper_reuse::reclaim<To>(t);
+  }
+};
+
+template <typename First, typename... Types>
+template <std::size_t index, typename... Args>
+bool
+variant<First, Types...>::reuse_wrapper_impl(std::true_type, Args &&... args) noexcept(
+  reuse_mode<index, Args...>::value != 2) {
+  using temp_t = typename storage_t::template value_t<index>;
+
+  reuse_checker<temp_t> c;
+  if (!this->apply_visitor_internal(c)) { return false; }
+
+  // Not in place, since `args` may refer into the value we are about to destroy
+  unwrap_type_t<temp_t> value(std::forward<Args>(args)...); // may throw
+
+  reclaimer<temp_t> r;
+  void * p = this->apply_visitor_internal(r);
+  STRICT_VARIANT_ASSERT(p, "Heap node reuse failed after its check!");
+
+  temp_t tmp(detail::wrapper_reuse::construct<temp_t>(p, std::move(value)));
+  this->destroy();
+  this->initialize<index>(std::move(tmp));
+  return true;
+}
+
 // Swap
 
 template <typename First, typename... Types>
 struct variant<First, Types...>::swapper {
+  typedef void result_type;
+
   using var_t = variant<First, Types...>;
 
   swapper(var_t & lhs_var, var_t & rhs_var)
@@ -780,6 +1398,8 @@ struct variant<First, Types...>::swapper {
 
   template <typename T>
   struct second_visitor {
+    typedef void result_type;
+
     var_t & first_var_;
     var_t & second_var_;
     T & first_visit_;
@@ -789,27 +1409,36 @@ struct variant<First, Types...>::swapper {
       , second_var_(second_var)
       , first_visit_(first_visit) {}
 
+    template <typename U>
+    void operator()(U & second_visit) const noexcept {
+      using same_swappable_t =
+        std::integral_constant<bool, std::is_same<T, U>::value
+                                       && mpl::is_nothrow_swappable<T>::value>;
+      this->swap_impl(second_visit, same_swappable_t{});
+    }
+
+  private:
     // If both give us a T, and T is noexcept swappable, then do that
-    mpl::enable_if_t<mpl::is_nothrow_swappable<T>::value> operator()(T & second_visit) const
-      noexcept {
+    template <typename U>
+    void swap_impl(U & second_visit, std::true_type) const noexcept {
       using std::swap;
       swap(first_visit_, second_visit);
     }
 
     // swap using a move
     template <typename U>
-    void operator()(U & second_visit) const noexcept {
+    void swap_impl(U & second_visit, std::false_type) const noexcept {
       constexpr std::size_t t_idx = var_t::find_which<T>::value;
       constexpr std::size_t u_idx = var_t::find_which<U>::value;
 
       STRICT_VARIANT_ASSERT(t_idx == first_var_.which(), "Bad access during swap!");
       STRICT_VARIANT_ASSERT(u_idx == second_var_.which(), "Bad access during swap!");
 
-      T temp{std::move(first_visit_)};
+      T temp(std::move(first_visit_));
       first_var_.destroy();
-      first_var_.initialize<u_idx>(std::move(second_visit));
+      first_var_.template initialize<u_idx>(std::move(second_visit));
       second_var_.destroy();
-      second_var_.initialize<t_idx>(std::move(temp));
+      second_var_.template initialize<t_idx>(std::move(temp));
     }
   };
 
@@ -821,8 +1450,13 @@ private:
 template <typename First, typename... Types>
 void
 variant<First, Types...>::swap(variant & other) noexcept {
-  swapper s{*this, other};
-  s.do_swap();
+  this->swap_impl(other, std::integral_constant<bool, noexcept_t::trivially_relocatable>{});
+}
+
+template <typename First, typename... Types>
+void
+swap(variant<First, Types...> & lhs, variant<First, Types...> & rhs) noexcept {
+  lhs.swap(rhs);
 }
 
 // Operator ==, !=
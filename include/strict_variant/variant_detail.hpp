@@ -5,7 +5,9 @@
 
 #pragma once
 
+#include <strict_variant/blank.hpp>
 #include <strict_variant/mpl/find_with.hpp>
+#include <strict_variant/relocate.hpp>
 #include <strict_variant/safely_constructible.hpp>
 #include <strict_variant/variant_fwd.hpp>
 #include <strict_variant/wrapper.hpp>
@@ -82,6 +84,14 @@ struct proper_subvariant {
  * The trick is that we need to support the case when recursive_wrapper is incomplete.
  */
 
+// Checks a trait of the value type of a wrapper, if it is known to be
+// complete, and otherwise assumes the worst.
+template <template <typename> class Trait, typename T, bool b = is_complete_wrapper<T>::value>
+struct wrapped_value_has : std::false_type {};
+
+template <template <typename> class Trait, typename T>
+struct wrapped_value_has<Trait, T, true> : Trait<typename T::value_type> {};
+
 template <typename T, bool b = is_wrapper<T>::value>
 struct is_nothrow_moveable_or_wrapper_impl : std::is_nothrow_move_constructible<T> {};
 
@@ -118,7 +128,8 @@ struct is_nothrow_moveable : is_nothrow_moveable_impl<T> {};
 template <typename T, bool b = is_wrapper<T>::value>
 struct is_nothrow_copyable_impl : std::is_nothrow_constructible<T, const T &> {};
 
-template <typename T> // Just assume it isn't, since it may be incomplete
+// Copying a wrapper makes a new allocation, (even if the type is complete)
+template <typename T>
 struct is_nothrow_copyable_impl<T, true> : std::false_type {};
 
 template <typename T>
@@ -127,21 +138,36 @@ struct is_nothrow_copyable : is_nothrow_copyable_impl<T> {};
 template <typename T, bool b = is_wrapper<T>::value>
 struct is_nothrow_move_assignable_impl : std::is_nothrow_move_assignable<T> {};
 
+// Assigning to a wrapper assigns to its value, in place
 template <typename T>
-struct is_nothrow_move_assignable_impl<T, true> : std::false_type {};
+struct is_nothrow_move_assignable_impl<T, true>
+  : wrapped_value_has<std::is_nothrow_move_assignable, T> {};
 
 template <typename T>
 struct is_nothrow_move_assignable : is_nothrow_move_assignable_impl<T> {};
 
+template <typename T, bool b = is_wrapper<T>::value>
+struct is_nothrow_move_assignable_or_wrapper_impl : std::is_nothrow_move_assignable<T> {};
+
+template <typename T>
+struct is_nothrow_move_assignable_or_wrapper_impl<T, true> : std::true_type {};
+
+template <typename T>
+struct is_nothrow_move_assignable_or_wrapper : is_nothrow_move_assignable_or_wrapper_impl<T> {};
+
 template <typename T, bool b = is_wrapper<T>::value>
 struct is_nothrow_copy_assignable_impl : std::is_nothrow_copy_assignable<T> {};
 
 template <typename T>
-struct is_nothrow_copy_assignable_impl<T, true> : std::false_type {};
+struct is_nothrow_copy_assignable_impl<T, true>
+  : wrapped_value_has<std::is_nothrow_copy_assignable, T> {};
 
 template <typename T>
 struct is_nothrow_copy_assignable : is_nothrow_copy_assignable_impl<T> {};
 
+template <typename T>
+struct is_blank : std::is_same<T, blank> {};
+
 template <typename First, typename... Types>
 struct variant_noexcept_helper {
   /***
@@ -178,17 +204,49 @@ struct variant_noexcept_helper {
     assume_move_nothrow
     || mpl::All_Have<detail::is_nothrow_moveable_or_wrapper, First, Types...>::value;
 
-  static constexpr bool nothrow_move_ctors =
+  // Moving the values out of a variant of these types, piercing any
+  // `recursive_wrapper`. (This is what the "generalizing" move operations do.)
+  static constexpr bool nothrow_value_move_ctors =
     assume_move_nothrow || mpl::All_Have<detail::is_nothrow_moveable, First, Types...>::value;
 
+  static constexpr bool nothrow_value_move_assign =
+    nothrow_value_move_ctors
+    && mpl::All_Have<detail::is_nothrow_move_assignable, First, Types...>::value;
+
+  // If `blank` is one of the types, a `recursive_wrapper` is moved by stealing
+  // its pointer, and the moved-from variant is left holding `blank`.
+  static constexpr bool has_blank = mpl::Find_Any<is_blank, First, Types...>::value;
+
+  static constexpr bool nothrow_move_ctors = nothrow_value_move_ctors || (has_blank && assignable);
+
   static constexpr bool nothrow_copy_ctors =
     assume_copy_nothrow || mpl::All_Have<detail::is_nothrow_copyable, First, Types...>::value;
 
+  // If there is a `blank`, move assignment also moves a `recursive_wrapper`
+  // by stealing its pointer, so it never allocates. Otherwise it pierces it.
   static constexpr bool nothrow_move_assign =
-    nothrow_move_ctors && mpl::All_Have<detail::is_nothrow_move_assignable, First, Types...>::value;
+    has_blank ? assignable
+                  && mpl::All_Have<detail::is_nothrow_move_assignable_or_wrapper, First,
+                                   Types...>::value
+              : nothrow_value_move_assign;
 
   static constexpr bool nothrow_copy_assign =
     nothrow_copy_ctors && mpl::All_Have<detail::is_nothrow_copy_assignable, First, Types...>::value;
+
+  // If every type is trivially copyable, then so is the variant, and its
+  // copies, moves and assignments are just copies of bytes.
+  static constexpr bool trivially_copyable =
+    mpl::All_Have<detail::is_trivially_copyable, First, Types...>::value;
+
+  // If every type is trivially destructible, then so is the variant, and
+  // changing its type doesn't need to destroy the old value.
+  static constexpr bool trivially_destructible =
+    mpl::All_Have<std::is_trivially_destructible, First, Types...>::value;
+
+  // If every type is trivially relocatable, then so is the variant, and swap
+  // just swaps the bytes.
+  static constexpr bool trivially_relocatable =
+    mpl::All_Have<is_trivially_relocatable, First, Types...>::value;
 };
 
 } // end namespace detail
@@ -5,13 +5,20 @@
 
 #pragma once
 
+#include <strict_variant/config.hpp>
 #include <strict_variant/mpl/find_with.hpp>
 #include <strict_variant/mpl/nonstd_traits.hpp>
 #include <strict_variant/mpl/std_traits.hpp>
 #include <strict_variant/mpl/typelist.hpp>
 #include <strict_variant/mpl/ulist.hpp>
 #include <strict_variant/variant_fwd.hpp>
+#include <strict_variant/variant_storage.hpp>
 
+#ifdef STRICT_VARIANT_DISPATCH_STATS
+#include <strict_variant/dispatch_stats.hpp>
+#endif
+
+#include <cstring>
 #include <type_traits>
 #include <utility>
 
@@ -32,8 +39,48 @@
 
 #endif // STRICT_VARIANT_DEBUG
 
+#if defined(__GNUC__)
+#define STRICT_VARIANT_LIKELY(X) __builtin_expect(!!(X), 1)
+#else
+#define STRICT_VARIANT_LIKELY(X) (X)
+#endif
+
+#if defined(__GNUC__)
+#define STRICT_VARIANT_UNREACHABLE()                                                               \
+  do {                                                                                             \
+    __builtin_unreachable();                                                                       \
+  } while (0)
+#elif defined(_MSC_VER)
+#define STRICT_VARIANT_UNREACHABLE()                                                               \
+  do {                                                                                             \
+    __assume(0);                                                                                   \
+  } while (0)
+#else
+#define STRICT_VARIANT_UNREACHABLE()                                                               \
+  do {                                                                                             \
+  } while (0)
+#endif
+
 namespace strict_variant {
 
+/***
+ * Trait which opts a visitor in to `dispatch::branchless`.
+ *
+ * A branchless visit calls the visitor on *every* alternative, and each call
+ * sees whatever bytes happen to be in the storage, read as that type. So the
+ * visitor must be pure (no side effects, since it runs once per alternative)
+ * and total over arbitrary bit patterns (no dereferencing pointers, no
+ * out-of-range float to int conversions, no division by a possibly-zero
+ * value, ...). Only the result for the active alternative is used.
+ *
+ * The compiler can't check this, so it is opt-in: specialize this trait to
+ * `std::true_type` for visitors which meet these requirements.
+ */
+//[ strict_variant_branchless_safe
+template <typename Visitor>
+struct branchless_safe : std::false_type {};
+//]
+
 namespace detail {
 
 /***
@@ -52,7 +99,7 @@ namespace detail {
   std::forward<Visitor>(v)(std::forward<Storage>(s).template get_value<index>(Internal()))
 
 template <unsigned index, typename Internal, typename Storage, typename Visitor>
-auto
+STRICT_VARIANT_CONSTEXPR14 auto
 visitor_caller(Storage && s, Visitor && v) noexcept(noexcept(RESULT_EXPR))
   -> decltype(RESULT_EXPR) {
   return RESULT_EXPR;
@@ -97,23 +144,51 @@ struct return_typer {
 /// This means we pick out the right function very quickly, but it may not be
 /// inlined by the compiler even if it is small.
 
+template <typename return_t, typename Internal, typename Storage, typename Visitor,
+          typename ulist>
+struct jumptable;
+
+template <typename return_t, typename Internal, typename Storage, typename Visitor,
+          unsigned... Indices>
+struct jumptable<return_t, Internal, Storage, Visitor, mpl::ulist<Indices...>> {
+  // Adapts visitor_caller to a common signature, so that they can all be put
+  // in one array.
+  template <unsigned index>
+  static STRICT_VARIANT_CONSTEXPR14 return_t caller(Storage && storage, Visitor && visitor) {
+    return visitor_caller<index, Internal, Storage, Visitor>(std::forward<Storage>(storage),
+                                                             std::forward<Visitor>(visitor));
+  }
+
+  using whichCaller = return_t (*)(Storage &&, Visitor &&);
+
+  // The table is a constant expression, so it is constant-initialized: there is
+  // no guard variable to check on each call, and no work at startup. One table
+  // exists per combination of storage and visitor, shared by all call sites.
+  static constexpr whichCaller callers[sizeof...(Indices)] = {&caller<Indices>...};
+};
+
+// Out-of-class definition, needed if the table is odr-used (C++11)
+template <typename return_t, typename Internal, typename Storage, typename Visitor,
+          unsigned... Indices>
+constexpr typename jumptable<return_t, Internal, Storage, Visitor,
+                             mpl::ulist<Indices...>>::whichCaller
+  jumptable<return_t, Internal, Storage, Visitor,
+            mpl::ulist<Indices...>>::callers[sizeof...(Indices)];
+
 template <typename return_t, typename Internal, typename ulist>
 struct jumptable_dispatch;
 
 template <typename return_t, typename Internal, unsigned... Indices>
 struct jumptable_dispatch<return_t, Internal, mpl::ulist<Indices...>> {
   template <typename Storage, typename Visitor>
-  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor)
-
-  {
-    using whichCaller = return_t (*)(Storage, Visitor);
-
-    static whichCaller callers[sizeof...(Indices)] = {
-      &visitor_caller<Indices, Internal, Storage, Visitor>...};
+  STRICT_VARIANT_CONSTEXPR14 return_t operator()(const unsigned int which, Storage && storage,
+                                                 Visitor && visitor) {
+    using table_t = jumptable<return_t, Internal, Storage, Visitor, mpl::ulist<Indices...>>;
 
     STRICT_VARIANT_ASSERT(which < static_cast<unsigned int>(sizeof...(Indices)));
 
-    return (*callers[which])(std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+    return (*table_t::callers[which])(std::forward<Storage>(storage),
+                                      std::forward<Visitor>(visitor));
   }
 };
 
@@ -137,7 +212,8 @@ struct binary_search_dispatch {
   static constexpr unsigned int half = num_types / 2;
 
   template <typename Storage, typename Visitor>
-  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+  STRICT_VARIANT_CONSTEXPR14 return_t operator()(const unsigned int which, Storage && storage,
+                                                 Visitor && visitor) {
 
     if (which < base + half) {
       return binary_search_dispatch<return_t, Internal, base, half>{}(
@@ -152,7 +228,8 @@ struct binary_search_dispatch {
 template <typename return_t, typename Internal, unsigned int base>
 struct binary_search_dispatch<return_t, Internal, base, 1u> {
   template <typename Storage, typename Visitor>
-  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+  STRICT_VARIANT_CONSTEXPR14 return_t operator()(const unsigned int which, Storage && storage,
+                                                 Visitor && visitor) {
     STRICT_VARIANT_ASSERT(which == base);
 
     return visitor_caller<base, Internal, Storage, Visitor>(std::forward<Storage>(storage),
@@ -160,15 +237,377 @@ struct binary_search_dispatch<return_t, Internal, base, 1u> {
   }
 };
 
-/// Choose the jumptable dispatch strategy when the number of types is > switch
-/// point
-/// choose the binary search dispatch for less than that.
-/// Tentatively choosing 4 for switch point, potentially 8 is better... ?
-/// Needs more rigorous benchmarking
-template <typename Internal, size_t num_types>
-struct visitor_dispatch {
-  // static constexpr unsigned int switch_point = 4;
+/// Same as the above, but we simply test each value of "which" in order.
+///
+/// This is a chain of comparisons rather than a tree, so it is only a good idea
+/// when there are very few types, or when the first few types are much more
+/// likely than the rest.
+
+template <typename return_t, typename Internal, unsigned int base, unsigned int num_types>
+struct linear_dispatch {
+  static_assert(num_types >= 2, "Something wrong with linear dispatch");
+
+  template <typename Storage, typename Visitor>
+  STRICT_VARIANT_CONSTEXPR14 return_t operator()(const unsigned int which, Storage && storage,
+                                                 Visitor && visitor) {
+    if (which == base) {
+      return visitor_caller<base, Internal, Storage, Visitor>(std::forward<Storage>(storage),
+                                                              std::forward<Visitor>(visitor));
+    } else {
+      return linear_dispatch<return_t, Internal, base + 1, num_types - 1>{}(
+        which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+    }
+  }
+};
+
+template <typename return_t, typename Internal, unsigned int base>
+struct linear_dispatch<return_t, Internal, base, 1u> {
+  template <typename Storage, typename Visitor>
+  STRICT_VARIANT_CONSTEXPR14 return_t operator()(const unsigned int which, Storage && storage,
+                                                 Visitor && visitor) {
+    STRICT_VARIANT_ASSERT(which == base);
+
+    return visitor_caller<base, Internal, Storage, Visitor>(std::forward<Storage>(storage),
+                                                            std::forward<Visitor>(visitor));
+  }
+};
+
+/// Same as the above, but we expand an actual `switch` statement, with one case
+/// for each value of "which".
+///
+/// The compiler is then free to build its own jump table (or whatever else it
+/// prefers), and unlike `jumptable_dispatch`, the visitor calls can still be
+/// inlined.
+///
+/// The cases are generated by the preprocessor, in chunks of 64. When there are
+/// fewer types than that, the extra cases are marked unreachable. When there are
+/// more, the default case moves on to the next chunk.
+
+template <typename return_t, typename Internal, unsigned int base, unsigned int offset,
+          unsigned int num_types>
+struct switch_case {
+  static constexpr bool valid = offset < num_types;
+
+  template <typename Storage, typename Visitor>
+  static STRICT_VARIANT_CONSTEXPR14 return_t call(Storage && storage, Visitor && visitor) {
+    if (!valid) { STRICT_VARIANT_UNREACHABLE(); }
+
+    return visitor_caller<(valid ? base + offset : base), Internal, Storage, Visitor>(
+      std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+  }
+};
+
+static constexpr unsigned int switch_chunk_size = 64;
+
+template <typename return_t, typename Internal, unsigned int base, unsigned int num_types>
+struct switch_dispatch;
+
+// The default case of a chunk. `num_remaining` is the number of types after this chunk.
+template <typename return_t, typename Internal, unsigned int base, unsigned int num_remaining>
+struct switch_default {
+  template <typename Storage, typename Visitor>
+  static STRICT_VARIANT_CONSTEXPR14 return_t call(const unsigned int which, Storage && storage,
+                                                  Visitor && visitor) {
+    return switch_dispatch<return_t, Internal, base + switch_chunk_size, num_remaining>{}(
+      which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+  }
+};
+
+template <typename return_t, typename Internal, unsigned int base>
+struct switch_default<return_t, Internal, base, 0u> {
+  template <typename Storage, typename Visitor>
+  static STRICT_VARIANT_CONSTEXPR14 return_t call(const unsigned int which, Storage && storage,
+                                                  Visitor && visitor) {
+    STRICT_VARIANT_ASSERT(false && which);
+    STRICT_VARIANT_UNREACHABLE();
+    return switch_case<return_t, Internal, base, 0, 1>::call(std::forward<Storage>(storage),
+                                                             std::forward<Visitor>(visitor));
+  }
+};
+
+#define STRICT_VARIANT_SWITCH_CASE(K)                                                              \
+  case base + (K):                                                                                 \
+    return switch_case<return_t, Internal, base, (K), num_types>::call(                            \
+      std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+
+#define STRICT_VARIANT_SWITCH_CASES_4(K)                                                           \
+  STRICT_VARIANT_SWITCH_CASE(K)                                                                    \
+  STRICT_VARIANT_SWITCH_CASE(K + 1)                                                                \
+  STRICT_VARIANT_SWITCH_CASE(K + 2)                                                                \
+  STRICT_VARIANT_SWITCH_CASE(K + 3)
+
+#define STRICT_VARIANT_SWITCH_CASES_16(K)                                                          \
+  STRICT_VARIANT_SWITCH_CASES_4(K)                                                                 \
+  STRICT_VARIANT_SWITCH_CASES_4(K + 4)                                                             \
+  STRICT_VARIANT_SWITCH_CASES_4(K + 8)                                                             \
+  STRICT_VARIANT_SWITCH_CASES_4(K + 12)
+
+#define STRICT_VARIANT_SWITCH_CASES_64(K)                                                          \
+  STRICT_VARIANT_SWITCH_CASES_16(K)                                                                \
+  STRICT_VARIANT_SWITCH_CASES_16(K + 16)                                                           \
+  STRICT_VARIANT_SWITCH_CASES_16(K + 32)                                                           \
+  STRICT_VARIANT_SWITCH_CASES_16(K + 48)
+
+template <typename return_t, typename Internal, unsigned int base, unsigned int num_types>
+struct switch_dispatch {
+  static_assert(switch_chunk_size == 64, "Cases below must match switch_chunk_size");
+
+  using default_t = switch_default<return_t, Internal, base,
+                                   (num_types > switch_chunk_size ? num_types - switch_chunk_size
+                                                                  : 0)>;
+
+  template <typename Storage, typename Visitor>
+  STRICT_VARIANT_CONSTEXPR14 return_t operator()(const unsigned int which, Storage && storage,
+                                                 Visitor && visitor) {
+    switch (which) {
+      STRICT_VARIANT_SWITCH_CASES_64(0)
+      default:
+        return default_t::call(which, std::forward<Storage>(storage),
+                               std::forward<Visitor>(visitor));
+    }
+  }
+};
+
+#undef STRICT_VARIANT_SWITCH_CASES_64
+#undef STRICT_VARIANT_SWITCH_CASES_16
+#undef STRICT_VARIANT_SWITCH_CASES_4
+#undef STRICT_VARIANT_SWITCH_CASE
+
+/// Dispatch which tests a few "hot" values of "which" first, marking them as
+/// likely, before handing off to some other dispatcher for the rest.
+///
+/// This is appropriate when the distribution of types is very skewed, and the
+/// programmer knows ahead of time which types are common.
+
+template <typename return_t, typename Internal, typename Fallback_t, unsigned int num_types,
+          unsigned int... hot>
+struct likely_dispatch;
+
+template <typename return_t, typename Internal, typename Fallback_t, unsigned int num_types>
+struct likely_dispatch<return_t, Internal, Fallback_t, num_types> {
+  template <typename Storage, typename Visitor>
+  STRICT_VARIANT_CONSTEXPR14 return_t operator()(const unsigned int which, Storage && storage,
+                                                 Visitor && visitor) {
+    return Fallback_t{}(which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+  }
+};
+
+template <typename return_t, typename Internal, typename Fallback_t, unsigned int num_types,
+          unsigned int h, unsigned int... hs>
+struct likely_dispatch<return_t, Internal, Fallback_t, num_types, h, hs...> {
+  static_assert(h < num_types, "Likely index is out of range for this variant!");
+
+  template <typename Storage, typename Visitor>
+  STRICT_VARIANT_CONSTEXPR14 return_t operator()(const unsigned int which, Storage && storage,
+                                                 Visitor && visitor) {
+    if (STRICT_VARIANT_LIKELY(which == h)) {
+      return visitor_caller<h, Internal, Storage, Visitor>(std::forward<Storage>(storage),
+                                                           std::forward<Visitor>(visitor));
+    } else {
+      return likely_dispatch<return_t, Internal, Fallback_t, num_types, hs...>{}(
+        which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+    }
+  }
+};
+
+/// Dispatch which does not branch on "which" at all: the visitor is evaluated
+/// against every alternative, and the result for "which" is picked out of a
+/// small array of results, which is just an indexed load.
+///
+/// This only makes sense when every alternative is trivial (so any bytes may
+/// be read as that type), and the visitor is cheap, noexcept, opted in with
+/// `branchless_safe`, and returns a trivial non-void value. The visitor sees
+/// each value as `const T &`, to a copy of the storage. When these conditions
+/// don't hold, `Fallback_t` is used.
+
+template <typename T>
+struct branchless_load {
+  static T load(const void * address) noexcept {
+    T result;
+    std::memcpy(&result, address, sizeof(T));
+    return result;
+  }
+};
+
+// Not every byte is a valid bool
+template <>
+struct branchless_load<bool> {
+  static bool load(const void * address) noexcept {
+    unsigned char result;
+    std::memcpy(&result, address, 1);
+    return result != 0;
+  }
+};
+
+template <typename return_t, typename Visitor, typename T, typename = void>
+struct branchless_callable : std::false_type {};
+
+template <typename return_t, typename Visitor, typename T>
+struct branchless_callable<return_t, Visitor, T,
+                           decltype(void(std::declval<Visitor &>()(std::declval<const T &>())))>
+  : std::integral_constant<bool,
+                           std::is_trivial<T>::value
+                             && noexcept(std::declval<Visitor &>()(std::declval<const T &>()))
+                             && std::is_convertible<decltype(std::declval<Visitor &>()(
+                                                      std::declval<const T &>())),
+                                                    return_t>::value> {};
+
+template <typename return_t, typename Internal, unsigned int num_types, typename Fallback_t>
+struct branchless_dispatch {
+  template <typename Storage, typename Visitor>
+  struct eligible : std::false_type {};
+
+  template <typename First, typename... Types, typename Visitor>
+  struct eligible<storage<First, Types...>, Visitor> {
+    template <typename T>
+    struct callable : branchless_callable<return_t, Visitor, T> {};
+
+    static constexpr bool value = std::is_same<Internal, false_>::value
+                                  && branchless_safe<mpl::remove_const_t<Visitor>>::value
+                                  && std::is_trivial<return_t>::value
+                                  && mpl::All_Have<callable, First, Types...>::value;
+  };
+
+  template <unsigned index, typename First, typename... Types, typename Visitor>
+  static return_t call(const storage<First, Types...> & s, Visitor & visitor) noexcept {
+    using T = typename storage<First, Types...>::template value_t<index>;
+    const T value = branchless_load<T>::load(s.address());
+    return visitor(value);
+  }
+
+  template <typename Storage, typename Visitor, unsigned... Indices>
+  static return_t select(const unsigned int which, const Storage & s, Visitor & visitor,
+                         mpl::ulist<Indices...>) noexcept {
+    const return_t results[] = {call<Indices>(s, visitor)...};
+    STRICT_VARIANT_ASSERT(which < static_cast<unsigned int>(sizeof...(Indices)));
+    return results[which];
+  }
+
+  template <typename Storage, typename Visitor>
+  return_t impl(const unsigned int which, Storage && storage, Visitor && visitor, std::true_type) {
+    return select(which, storage, visitor, mpl::count_t<num_types>{});
+  }
+
+  template <typename Storage, typename Visitor>
+  return_t impl(const unsigned int which, Storage && storage, Visitor && visitor, std::false_type) {
+    return Fallback_t{}(which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+  }
+
+  template <typename Storage, typename Visitor>
+  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+    using eligible_t = eligible<mpl::remove_const_t<mpl::remove_reference_t<Storage>>,
+                                mpl::remove_reference_t<Visitor>>;
+    return this->impl(which, std::forward<Storage>(storage), std::forward<Visitor>(visitor),
+                      std::integral_constant<bool, eligible_t::value>{});
+  }
+};
 
+} // end namespace detail
+
+/***
+ * Dispatch policies:
+ *   A dispatch policy selects which of the above strategies is used to
+ *   dispatch a visitor, given the return type, the visit mode, and the number
+ *   of types in the variant.
+ *
+ *   A policy is a class with a member alias template
+ *     template <typename return_t, typename Internal, unsigned num_types>
+ *     using dispatcher_t = ...;
+ *   naming a default-constructible function object like the ones above.
+ */
+namespace dispatch {
+
+struct binary_search {
+  template <typename return_t, typename Internal, unsigned int num_types>
+  using dispatcher_t = detail::binary_search_dispatch<return_t, Internal, 0, num_types>;
+};
+
+struct jumptable {
+  template <typename return_t, typename Internal, unsigned int num_types>
+  using dispatcher_t = detail::jumptable_dispatch<return_t, Internal, mpl::count_t<num_types>>;
+};
+
+struct linear {
+  template <typename return_t, typename Internal, unsigned int num_types>
+  using dispatcher_t = detail::linear_dispatch<return_t, Internal, 0, num_types>;
+};
+
+struct switch_table {
+  template <typename return_t, typename Internal, unsigned int num_types>
+  using dispatcher_t = detail::switch_dispatch<return_t, Internal, 0, num_types>;
+};
+
+/// Use `Small` when there are at most `switch_point` types, and `Large` otherwise.
+template <unsigned int switch_point, typename Small = binary_search, typename Large = jumptable>
+struct hybrid {
+  template <typename return_t, typename Internal, unsigned int num_types>
+  using dispatcher_t = typename std::conditional<
+    (num_types > switch_point),
+    typename Large::template dispatcher_t<return_t, Internal, num_types>,
+    typename Small::template dispatcher_t<return_t, Internal, num_types>>::type;
+};
+
+/// Test the indices `hot...` first, in order, and mark them as likely.
+/// Use `Fallback` for the remaining cases.
+template <typename Fallback, unsigned int... hot>
+struct likely {
+  template <typename return_t, typename Internal, unsigned int num_types>
+  using dispatcher_t =
+    detail::likely_dispatch<return_t, Internal,
+                            typename Fallback::template dispatcher_t<return_t, Internal, num_types>,
+                            num_types, hot...>;
+};
+
+/// The switch point of the default policy.
+/// This comes from the `bench/` visitation benchmarks (gcc 12, -O3, with and
+/// without OPAQUE_VISIT):
+///  - Up to 4 types, `switch_table` is best, and often collapses to a table of
+///    results or a couple of conditional moves.
+///  - From 5 to about 32 types, the comparison chain of `linear` beats the
+///    single indirect jump of `switch_table`, which mispredicts on random data.
+///  - Past 32 types, `switch_table` is best, and stays nearly flat as the number
+///    of types grows, while `linear` and `binary_search` keep getting slower.
+///  - `jumptable` never wins, since the visitor can't be inlined.
+#ifdef STRICT_VARIANT_DISPATCH_SWITCH_POINT
+static constexpr unsigned int default_switch_point = STRICT_VARIANT_DISPATCH_SWITCH_POINT;
+#else
+static constexpr unsigned int default_switch_point = 32;
+#endif
+
+using default_policy = hybrid<4, switch_table, hybrid<default_switch_point, linear, switch_table>>;
+
+/// Evaluate the visitor for every alternative and select the result, with no
+/// branches, when all alternatives are trivial and the visitor is noexcept,
+/// returns a trivial value, and is opted in with `branchless_safe`. Use
+/// `Fallback` otherwise. Meant for variants of a few small arithmetic types.
+template <typename Fallback = default_policy>
+struct branchless {
+  template <typename return_t, typename Internal, unsigned int num_types>
+  using dispatcher_t =
+    detail::branchless_dispatch<return_t, Internal, num_types,
+                                typename Fallback::template dispatcher_t<return_t, Internal,
+                                                                         num_types>>;
+};
+
+} // end namespace dispatch
+
+/***
+ * Trait which selects the dispatch policy for a particular variant type.
+ * Specialize this trait to change the policy used for that type.
+ */
+//[ strict_variant_dispatch_policy
+template <typename Variant>
+struct dispatch_policy {
+  using type = dispatch::default_policy;
+};
+//]
+
+namespace detail {
+
+/// Choose a dispatch strategy according to the policy, and figure out the
+/// return type and noexcept status of the visit.
+template <typename Internal, size_t num_types, typename Policy = dispatch::default_policy>
+struct visitor_dispatch {
   // Helper which takes the conjunction of a typelist of `std::integral_constant<bool>`.
   template <typename T>
   struct conjunction;
@@ -197,21 +636,17 @@ struct visitor_dispatch {
 
   // Invoke the actual dispatcher
   template <typename Storage, typename Visitor>
-  auto operator()(const unsigned int which, Storage && storage,
+  STRICT_VARIANT_CONSTEXPR14 auto operator()(const unsigned int which, Storage && storage,
                   Visitor && visitor) noexcept(call_helper<Storage, Visitor>::noexcept_value) ->
     typename call_helper<Storage, Visitor>::return_type {
 
     using return_t = typename call_helper<Storage, Visitor>::return_type;
 
-    // using chosen_dispatch_t = jumptable_dispatch<return_t, Internal, mpl::count_t<num_types>>;
-
-    // using chosen_dispatch_t =
-    //  typename std::conditional<(num_types > switch_point),
-    //  jumptable_dispatch<return_t, Internal,  mpl::count_t<num_types>>,
-    //                            binary_search_dispatch<return_t, Internal, 0,
-    //                             num_types>>::type;
+    using chosen_dispatch_t = typename Policy::template dispatcher_t<return_t, Internal, num_types>;
 
-    using chosen_dispatch_t = binary_search_dispatch<return_t, Internal, 0, num_types>;
+#ifdef STRICT_VARIANT_DISPATCH_STATS
+    dispatch_stats<Internal, mpl::remove_const_t<mpl::remove_reference_t<Storage>>>::record(which);
+#endif
 
     return chosen_dispatch_t{}(which, std::forward<Storage>(storage),
                                std::forward<Visitor>(visitor));
@@ -223,3 +658,5 @@ struct visitor_dispatch {
 } // end namespace strict_variant
 
 #undef STRICT_VARIANT_ASSERT
+#undef STRICT_VARIANT_UNREACHABLE
+#undef STRICT_VARIANT_LIKELY
@@ -10,6 +10,9 @@ namespace strict_variant {
 template <typename T>
 class recursive_wrapper;
 
+template <typename T>
+class heap_wrapper;
+
 template <typename First, typename... Types>
 class variant;
 
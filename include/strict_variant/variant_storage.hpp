@@ -5,10 +5,15 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <new>
+#include <strict_variant/config.hpp>
+#include <strict_variant/mpl/find_with.hpp>
 #include <strict_variant/mpl/max.hpp>
 #include <strict_variant/mpl/typelist.hpp>
 #include <strict_variant/wrapper.hpp>
+#include <type_traits>
 #include <utility>
 
 namespace strict_variant {
@@ -24,10 +29,165 @@ namespace detail {
 struct true_ {};
 struct false_ {};
 
+// Tag used to construct the storage holding the type at a particular index
+template <std::size_t index>
+using index_tag = std::integral_constant<std::size_t, index>;
+
 // Storage for the types in a list of types.
 // Provides typed access using the index within the list as a template parameter.
 // And some facilities for piercing recursive_wrapper
 
+#ifdef STRICT_VARIANT_UNION_STORAGE
+
+/***
+ * Recursive union backend.
+ *
+ * The value is a member of a union, nested once per type, as in eggs::variant.
+ * No `reinterpret_cast` is needed to access it, so the variant can be
+ * constructed and visited in constant expressions, (if all the types are
+ * literal types). The optimizer can also see the type of the value.
+ *
+ * When default constructed, the `m_none` member is active, and the value is
+ * created later with placement new.
+ *
+ * The destructor must be user-provided if any member's destructor is not
+ * trivial, so there are two versions, which are otherwise the same.
+ */
+
+template <bool trivial_dtor, typename... Types>
+union recursive_union;
+
+template <bool trivial_dtor>
+union recursive_union<trivial_dtor> {
+  char m_none;
+
+  constexpr recursive_union() noexcept
+    : m_none() {}
+};
+
+#define STRICT_VARIANT_RECURSIVE_UNION_BODY(TRIVIAL)                                               \
+  char m_none;                                                                                     \
+  T m_head;                                                                                        \
+  recursive_union<TRIVIAL, Ts...> m_tail;                                                          \
+                                                                                                   \
+  constexpr recursive_union() noexcept                                                             \
+    : m_none() {}                                                                                  \
+                                                                                                   \
+  template <typename... Args>                                                                      \
+  constexpr recursive_union(index_tag<0>, Args &&... args)                                         \
+    : m_head(std::forward<Args>(args)...) {}                                                       \
+                                                                                                   \
+  template <std::size_t index, typename... Args>                                                   \
+  constexpr recursive_union(index_tag<index>, Args &&... args)                                     \
+    : m_tail(index_tag<index - 1>{}, std::forward<Args>(args)...) {}
+
+template <typename T, typename... Ts>
+union recursive_union<true, T, Ts...> {
+  STRICT_VARIANT_RECURSIVE_UNION_BODY(true)
+};
+
+template <typename T, typename... Ts>
+union recursive_union<false, T, Ts...> {
+  STRICT_VARIANT_RECURSIVE_UNION_BODY(false)
+
+  ~recursive_union() noexcept {}
+};
+
+#undef STRICT_VARIANT_RECURSIVE_UNION_BODY
+
+// Typed access to the member at an index of a recursive union
+template <std::size_t index>
+struct union_access {
+  template <typename U>
+  static constexpr auto & get(U & u) noexcept {
+    return union_access<index - 1>::get(u.m_tail);
+  }
+};
+
+template <>
+struct union_access<0> {
+  template <typename U>
+  static constexpr auto & get(U & u) noexcept {
+    return u.m_head;
+  }
+};
+
+template <typename First, typename... Types>
+struct storage {
+  using union_t =
+    recursive_union<mpl::All_Have<std::is_trivially_destructible, First, Types...>::value, First,
+                    Types...>;
+  union_t m_union;
+
+  storage() = default;
+
+  template <size_t index, typename... Args>
+  constexpr storage(index_tag<index> tag, Args &&... args)
+    : m_union(tag, std::forward<Args>(args)...) {}
+
+  void * address() { return static_cast<void *>(&m_union); }
+  const void * address() const { return static_cast<const void *>(&m_union); }
+
+  /***
+   * Index -> Type
+   */
+  using my_types = mpl::TypeList<First, Types...>;
+
+  template <size_t index>
+  using value_t = mpl::Index_At<my_types, index>;
+
+  /***
+   * Initialize to the type at a particular value
+   */
+  template <size_t index, typename... Args>
+  void initialize(Args &&... args) noexcept(
+    noexcept(value_t<index>(std::forward<Args>(std::declval<Args>())...))) {
+    new (this->address()) value_t<index>(std::forward<Args>(args)...);
+  }
+
+  /***
+   * Typed access which pierces recursive_wrapper if detail::false_ is passed
+   * "Internal" (non-piercing) access is achieved if detail::true_ is passed
+   */
+  template <size_t index>
+  constexpr value_t<index> & get_value(detail::true_) & {
+    return union_access<index>::get(m_union);
+  }
+
+  template <size_t index>
+  constexpr const value_t<index> & get_value(detail::true_) const & {
+    return union_access<index>::get(m_union);
+  }
+
+  template <size_t index>
+  constexpr value_t<index> && get_value(detail::true_) && {
+    return std::move(union_access<index>::get(m_union));
+  }
+
+  template <size_t index>
+  constexpr unwrap_type_t<value_t<index>> & get_value(detail::false_) & {
+    return detail::pierce_wrapper(this->get_value<index>(detail::true_{}));
+  }
+
+  template <size_t index>
+  constexpr const unwrap_type_t<value_t<index>> & get_value(detail::false_) const & {
+    return detail::pierce_wrapper(this->get_value<index>(detail::true_{}));
+  }
+
+  template <size_t index>
+  constexpr unwrap_type_t<value_t<index>> && get_value(detail::false_) && {
+    return std::move(detail::pierce_wrapper(this->get_value<index>(detail::true_{})));
+  }
+};
+
+#else // STRICT_VARIANT_UNION_STORAGE
+
+/***
+ * Aligned storage backend (default).
+ *
+ * The value is created in a suitably aligned buffer with placement new.
+ */
+
 template <typename First, typename... Types>
 struct storage {
 
@@ -61,6 +221,13 @@ struct storage {
   void * address() { return reinterpret_cast<void *>(&m_storage); }
   const void * address() const { return reinterpret_cast<const void *>(&m_storage); }
 
+  storage() = default;
+
+  template <size_t index, typename... Args>
+  storage(index_tag<index>, Args &&... args) {
+    this->initialize<index>(std::forward<Args>(args)...);
+  }
+
   /***
    * Index -> Type
    */
@@ -113,5 +280,100 @@ struct storage {
   }
 };
 
+#endif // STRICT_VARIANT_UNION_STORAGE
+
+/***
+ * Whether a storage type keeps its discriminator in the low bits of a
+ * pointer. This is the case when every type is a tagged pointer wrapper, and
+ * there are few enough types that every index fits in the tag bits.
+ */
+template <typename Storage>
+struct use_pointer_tag;
+
+template <typename First, typename... Types>
+struct use_pointer_tag<storage<First, Types...>> {
+  static constexpr bool value =
+    mpl::All_Have<is_tagged_pointer_wrapper, First, Types...>::value
+    && (sizeof...(Types) <= pointer_tag_mask)
+    && (sizeof(storage<First, Types...>) == sizeof(std::uintptr_t));
+};
+
+/***
+ * Storage, together with the index of the type that it currently holds.
+ * By default, the index is a separate member of type `Which`.
+ */
+template <typename Storage, typename Which, bool tagged = use_pointer_tag<Storage>::value>
+struct discriminated_storage : Storage {
+  Which m_which;
+
+  discriminated_storage() = default;
+
+  template <size_t index, typename... Args>
+  STRICT_VARIANT_CONSTEXPR14 discriminated_storage(index_tag<index> tag, Args &&... args)
+    : Storage(tag, std::forward<Args>(args)...)
+    , m_which(static_cast<Which>(index)) {}
+
+  constexpr unsigned which() const noexcept { return static_cast<unsigned>(m_which); }
+  void set_which(std::size_t index) noexcept { m_which = static_cast<Which>(index); }
+
+  // Initialize the storage to the type at a particular index, and record it
+  template <size_t index, typename... Args>
+  void initialize(Args &&... args) noexcept(
+    noexcept(std::declval<Storage &>().template initialize<index>(
+      std::forward<Args>(std::declval<Args>())...))) {
+    Storage::template initialize<index>(std::forward<Args>(args)...);
+    this->set_which(index);
+  }
+
+  STRICT_VARIANT_CONSTEXPR14 Storage & payload() & noexcept { return *this; }
+  constexpr const Storage & payload() const & noexcept { return *this; }
+  STRICT_VARIANT_CONSTEXPR14 Storage && payload() && noexcept { return std::move(*this); }
+};
+
+/***
+ * Tagged pointer mode: the index is kept in the low bits of the pointer held
+ * by whichever wrapper is in the storage. The wrappers all mask these bits
+ * off, and set_which must be called after every initialization, since that
+ * writes a fresh pointer.
+ *
+ * The word is accessed with memcpy, because we don't know (or care) which
+ * wrapper type is actually alive there.
+ */
+template <typename Storage, typename Which>
+struct discriminated_storage<Storage, Which, true> : Storage {
+  discriminated_storage() = default;
+
+  template <size_t index, typename... Args>
+  discriminated_storage(index_tag<index> tag, Args &&... args)
+    : Storage(tag, std::forward<Args>(args)...) {
+    this->set_which(index);
+  }
+
+  std::uintptr_t word() const noexcept {
+    std::uintptr_t result;
+    std::memcpy(&result, this->address(), sizeof(result));
+    return result;
+  }
+
+  unsigned which() const noexcept { return static_cast<unsigned>(this->word() & pointer_tag_mask); }
+
+  void set_which(std::size_t index) noexcept {
+    const std::uintptr_t w = (this->word() & ~pointer_tag_mask) | index;
+    std::memcpy(this->address(), &w, sizeof(w));
+  }
+
+  template <size_t index, typename... Args>
+  void initialize(Args &&... args) noexcept(
+    noexcept(std::declval<Storage &>().template initialize<index>(
+      std::forward<Args>(std::declval<Args>())...))) {
+    Storage::template initialize<index>(std::forward<Args>(args)...);
+    this->set_which(index);
+  }
+
+  Storage & payload() & noexcept { return *this; }
+  const Storage & payload() const & noexcept { return *this; }
+  Storage && payload() && noexcept { return std::move(*this); }
+};
+
 } // end namespace detail
 } // end namespace strict_variant
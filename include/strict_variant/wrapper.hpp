@@ -5,7 +5,12 @@
 
 #pragma once
 
+#include <strict_variant/config.hpp>
 #include <strict_variant/mpl/std_traits.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
 #include <type_traits>
 #include <utility>
 
@@ -26,6 +31,117 @@ struct is_wrapper : std::false_type {};
 } // end namespace detail
 //]
 
+namespace detail {
+
+/***
+ * Trait to identify wrappers which consist of exactly one owning pointer,
+ * and which ignore the low bits of that pointer (those masked by
+ * `pointer_tag_mask`). A variant all of whose types are such wrappers keeps
+ * `which` in those bits, and is only the size of a pointer.
+ */
+
+template <typename T>
+struct is_tagged_pointer_wrapper : std::false_type {};
+
+/***
+ * Trait to identify wrappers whose value type is always complete where they
+ * are used, like `heap_wrapper`. The `noexcept` traits of the variant
+ * interrogate the value type of such a wrapper, instead of assuming the worst.
+ */
+
+template <typename T>
+struct is_complete_wrapper : std::false_type {};
+
+// The bits of a pointer to a node allocated by `global_node` which are always
+// zero. (A class-specific `operator new` only has to align to `alignof(T)`.)
+static constexpr std::uintptr_t pointer_tag_mask = alignof(std::max_align_t) - 1;
+
+/***
+ * Allocation of the node of a wrapper with the global allocation functions.
+ *
+ * Since C++17, `operator new(n)` only has to align for objects of size `n`,
+ * and e.g. jemalloc and tcmalloc return 8-aligned blocks of 8 bytes or less.
+ * So the size is rounded up to a multiple of `alignof(std::max_align_t)`,
+ * and then the block must be aligned at least that much, and the bits masked
+ * by `pointer_tag_mask` are zero. A node must be freed by `deallocate`, since
+ * `delete` would pass the wrong size to a sized deallocation function.
+ */
+template <typename T>
+struct global_node {
+  static constexpr std::size_t size =
+    (sizeof(T) + pointer_tag_mask) & ~static_cast<std::size_t>(pointer_tag_mask);
+
+#ifdef __cpp_aligned_new
+  // As for a new-expression
+  using over_aligned =
+    std::integral_constant<bool, (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)>;
+#else
+  using over_aligned = std::false_type;
+#endif
+
+  static void * allocate() { return allocate(over_aligned{}); }
+  static void deallocate(void * p) noexcept { deallocate(p, over_aligned{}); }
+
+  // Frees the node on scope exit, unless released, e.g. if a constructor throws
+  struct guard {
+    void * p;
+
+    ~guard() noexcept {
+      if (p) { deallocate(p); }
+    }
+  };
+
+private:
+  static void * allocate(std::false_type) { return ::operator new(size); }
+  static void deallocate(void * p, std::false_type) noexcept { ::operator delete(p); }
+
+#ifdef __cpp_aligned_new
+  static void * allocate(std::true_type) {
+    return ::operator new(size, std::align_val_t{alignof(T)});
+  }
+  static void deallocate(void * p, std::true_type) noexcept {
+    ::operator delete(p, std::align_val_t{alignof(T)});
+  }
+#endif
+};
+
+/***
+ * Trait to detect class-specific allocation functions, that is, whether
+ * `new T` and `delete p` call `T::operator new` and `T::operator delete`
+ * rather than the global ones. `T` must be complete.
+ */
+
+template <typename T, typename = void>
+struct has_class_operator_new : std::false_type {};
+
+template <typename T>
+struct has_class_operator_new<T, decltype(void(T::operator new(std::size_t{})))>
+  : std::true_type {};
+
+// The usual member `operator delete` may take the size, or not
+template <typename T, typename = void>
+struct has_class_sized_operator_delete : std::false_type {};
+
+template <typename T>
+struct has_class_sized_operator_delete<
+  T, decltype(void(T::operator delete(static_cast<void *>(nullptr), std::size_t{})))>
+  : std::true_type {};
+
+template <typename T, typename = void>
+struct has_class_operator_delete : has_class_sized_operator_delete<T> {};
+
+template <typename T>
+struct has_class_operator_delete<T,
+                                 decltype(void(T::operator delete(static_cast<void *>(nullptr))))>
+  : std::true_type {};
+
+template <typename T>
+struct has_class_allocation
+  : std::integral_constant<bool, has_class_operator_new<T>::value
+                                   || has_class_operator_delete<T>::value> {};
+
+} // end namespace detail
+
 //[ strict_variant_pierce_wrapper
 namespace detail {
 
@@ -34,7 +150,7 @@ namespace detail {
  */
 
 template <typename T>
-inline auto
+STRICT_VARIANT_CONSTEXPR14 auto
 pierce_wrapper(T && t)
   -> mpl::enable_if_t<!is_wrapper<mpl::remove_const_t<mpl::remove_reference_t<T>>>::value, T> {
   return std::forward<T>(t);
@@ -70,4 +186,33 @@ struct unwrap_type<T, true> {
 template <typename T>
 using unwrap_type_t = typename unwrap_type<T>::type;
 
+namespace detail {
+
+/***
+ * True if the first of the arguments is `std::allocator_arg_t`. Wrappers use
+ * this to tell their value constructor from the one taking an allocator.
+ */
+template <typename... Args>
+struct leading_allocator_arg : std::false_type {};
+
+template <typename First, typename... Args>
+struct leading_allocator_arg<First, Args...>
+  : std::is_same<mpl::remove_const_t<mpl::remove_reference_t<First>>, std::allocator_arg_t> {};
+
+/***
+ * Moves a (non-pierced) value into the storage of a variant, leaving the
+ * source holding a value. A wrapper is pierced, and its value is moved into a
+ * new wrapper. Wrappers which carry an allocator specialize this, to construct
+ * the new wrapper with the same allocator.
+ */
+template <typename W>
+struct wrapper_value_mover {
+  template <std::size_t index, typename Storage>
+  static void move_value(Storage & storage, W & w) {
+    storage.template initialize<index>(pierce_wrapper(std::move(w)));
+  }
+};
+
+} // end namespace detail
+
 } // end namespace strict_variant
@@ -4,14 +4,19 @@
 //  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include <strict_variant/alloc_variant.hpp>
+#include <strict_variant/pool_allocator.hpp>
 #include <strict_variant/variant.hpp>
 
 #include "test_harness/test_harness.hpp"
 
+#include <cstddef>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 // Test that variant with standard allocator works
 
@@ -68,6 +73,215 @@ UNIT_TEST(std_allocator) {
   TEST_EQ(b.which(), 1);
 }
 
+// A stateful allocator, which counts allocations in an arena. When default
+// constructed, it uses the current arena.
+
+namespace test_two {
+
+struct arena {
+  int allocations;
+  int deallocations;
+
+  arena()
+    : allocations(0)
+    , deallocations(0) {}
+};
+
+static arena * current_arena = nullptr;
+
+template <typename T>
+struct arena_alloc {
+  typedef T value_type;
+
+  arena * m_arena;
+
+  arena_alloc() noexcept : m_arena(current_arena) {}
+
+  explicit arena_alloc(arena * a) noexcept : m_arena(a) {}
+
+  template <typename U>
+  arena_alloc(const arena_alloc<U> & other) noexcept : m_arena(other.m_arena) {}
+
+  T * allocate(std::size_t n) {
+    ++m_arena->allocations;
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T * p, std::size_t) noexcept {
+    ++m_arena->deallocations;
+    ::operator delete(p);
+  }
+};
+
+template <typename T, typename U>
+bool
+operator==(const arena_alloc<T> & a, const arena_alloc<U> & b) {
+  return a.m_arena == b.m_arena;
+}
+
+template <typename T, typename U>
+bool
+operator!=(const arena_alloc<T> & a, const arena_alloc<U> & b) {
+  return a.m_arena != b.m_arena;
+}
+
+using var_t = alloc_variant<arena_alloc>::type<int, A, B>;
+
+template <typename T>
+struct bound_alloc : arena_alloc<T> {
+  explicit bound_alloc(arena * a) noexcept : arena_alloc<T>(a) {}
+
+  template <typename U>
+  bound_alloc(const bound_alloc<U> & other) noexcept : arena_alloc<T>(other.m_arena) {}
+};
+
+using bound_var_t = alloc_variant<bound_alloc>::type<int, A, B>;
+
+static_assert(sizeof(alloc_wrapper<A, std::allocator<A>>) == sizeof(A *), "failed a unit test");
+static_assert(sizeof(alloc_wrapper<A, arena_alloc<A>>) == 2 * sizeof(A *), "failed a unit test");
+static_assert(is_trivially_relocatable<alloc_wrapper<A, std::allocator<A>>>::value,
+              "failed a unit test");
+static_assert(is_trivially_relocatable<alloc_wrapper<A, arena_alloc<A>>>::value,
+              "failed a unit test");
+
+} // end namespace test_two
+
+UNIT_TEST(stateful_allocator) {
+  using namespace test_two;
+
+  arena arena1;
+  arena arena2;
+
+  {
+    current_arena = &arena1;
+
+    var_t v = A{};
+    TEST_EQ(v.which(), 1);
+    TEST_EQ(arena1.allocations, 1);
+
+    // Emplace with a particular allocator
+    v.emplace<B>(std::allocator_arg, arena_alloc<B>{&arena2});
+    TEST_EQ(v.which(), 2);
+    TEST_EQ(arena1.deallocations, 1);
+    TEST_EQ(arena2.allocations, 1);
+
+    // A copy uses the same arena
+    var_t w{v};
+    TEST_EQ(w.which(), 2);
+    TEST_EQ(arena1.allocations, 1);
+    TEST_EQ(arena2.allocations, 2);
+
+    // A move leaves a value in the source, and uses the same arena
+    var_t x{std::move(w)};
+    TEST_EQ(x.which(), 2);
+    TEST_EQ(arena1.allocations, 1);
+    TEST_EQ(arena2.allocations, 3);
+
+    x = 5;
+    TEST_EQ(x.which(), 0);
+    TEST_EQ(arena2.deallocations, 1);
+
+    swap(v, x);
+    TEST_EQ(v.which(), 0);
+    TEST_EQ(x.which(), 2);
+    TEST_EQ(arena2.deallocations, 1);
+
+    // A type-changing copy assignment also uses the same arena
+    var_t y = A{};
+    TEST_EQ(arena1.allocations, 2);
+    y = x;
+    TEST_EQ(y.which(), 2);
+    TEST_EQ(arena1.allocations, 2);
+    TEST_EQ(arena1.deallocations, 2);
+    TEST_EQ(arena2.allocations, 4);
+
+    current_arena = nullptr;
+  }
+
+  {
+    // An allocator which can't be default constructed
+    bound_var_t v{5};
+    v.emplace<A>(std::allocator_arg, bound_alloc<A>{&arena1});
+    TEST_EQ(arena1.allocations, 3);
+
+    bound_var_t w{7};
+    w = v;
+    TEST_EQ(w.which(), 1);
+    TEST_EQ(arena1.allocations, 4);
+  }
+
+  TEST_EQ(arena1.allocations, arena1.deallocations);
+  TEST_EQ(arena2.allocations, arena2.deallocations);
+}
+
+// Pooling allocator, with blocks freed by the owning thread and by another
+
+UNIT_TEST(pool_allocator) {
+  using var_t = alloc_variant<pool_allocator>::type<std::string, A, B>;
+  static_assert(sizeof(alloc_wrapper<A, pool_allocator<A>>) == sizeof(A *), "failed a unit test");
+  static_assert(is_trivially_relocatable<alloc_wrapper<A, pool_allocator<A>>>::value,
+                "failed a unit test");
+
+  const node_pool_stats before = pool_allocator_thread_stats();
+
+  {
+    std::vector<var_t> vec;
+    vec.reserve(100);
+    for (int i = 0; i < 100; ++i) {
+      if (i % 2) {
+        vec.emplace_back(A{});
+      } else {
+        vec.emplace_back(B{});
+      }
+    }
+    TEST_EQ(vec[0].which(), 2);
+    TEST_EQ(vec[1].which(), 1);
+
+    const node_pool_stats s = pool_allocator_thread_stats();
+    TEST_EQ(s.allocations - before.allocations, 100u);
+    TEST_EQ(s.deallocations - before.deallocations, 0u);
+  }
+
+  const node_pool_stats local = pool_allocator_thread_stats();
+  TEST_EQ(local.allocations - before.allocations, 100u);
+  TEST_EQ(local.deallocations - before.deallocations, 100u);
+
+  // Blocks freed by another thread go back to this thread's cache, and are
+  // reused from there
+  {
+    std::vector<var_t> vec;
+    vec.reserve(50);
+    for (int i = 0; i < 50; ++i) {
+      vec.emplace_back(A{});
+    }
+
+    std::thread t{[](std::vector<var_t> v) { v.clear(); }, std::move(vec)};
+    t.join();
+  }
+
+  const node_pool_stats remote = pool_allocator_thread_stats();
+  TEST_EQ(remote.allocations - before.allocations, 150u);
+  TEST_EQ(remote.deallocations - before.deallocations, 100u);
+  TEST_EQ(remote.remote_deallocations - before.remote_deallocations, 50u);
+
+  {
+    std::vector<var_t> vec;
+    vec.reserve(50);
+    for (int i = 0; i < 50; ++i) {
+      vec.emplace_back(A{});
+    }
+  }
+
+  const node_pool_stats reused = pool_allocator_thread_stats();
+  TEST_EQ(reused.allocations - before.allocations, 200u);
+  TEST_EQ(reused.slabs, remote.slabs);
+
+  // The totals include the counts of every thread
+  const node_pool_stats total = pool_allocator_stats();
+  TEST_TRUE(total.allocations >= reused.allocations);
+  TEST_TRUE(total.remote_deallocations >= reused.remote_deallocations);
+}
+
 int
 main() {
 
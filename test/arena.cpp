@@ -0,0 +1,200 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Tests of arena_wrapper and monotonic_arena
+
+#include <strict_variant/arena_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+/***
+ * A small expression tree
+ */
+
+struct add;
+struct mul;
+
+using expr = variant<int, arena_wrapper<add>, arena_wrapper<mul>>;
+
+struct add {
+  expr lhs;
+  expr rhs;
+};
+
+struct mul {
+  expr lhs;
+  expr rhs;
+};
+
+struct evaluator {
+  int operator()(int i) const { return i; }
+  int operator()(const add & a) const {
+    return apply_visitor(*this, a.lhs) + apply_visitor(*this, a.rhs);
+  }
+  int operator()(const mul & m) const {
+    return apply_visitor(*this, m.lhs) * apply_visitor(*this, m.rhs);
+  }
+};
+
+// The whole tree is trivially destructible, so freeing it doesn't visit it
+static_assert(std::is_trivially_destructible<arena_wrapper<add>>::value, "failed a unit test");
+static_assert(std::is_trivially_destructible<expr>::value, "failed a unit test");
+static_assert(std::is_trivially_destructible<add>::value, "failed a unit test");
+static_assert(is_trivially_relocatable<expr>::value, "failed a unit test");
+static_assert(sizeof(arena_wrapper<add>) == sizeof(add *), "failed a unit test");
+
+UNIT_TEST(arena_tree) {
+  monotonic_arena arena{256};
+
+  {
+    arena_scope scope{arena};
+
+    // (2 + 3) * (4 + 5)
+    expr e = mul{add{2, 3}, add{4, 5}};
+    TEST_EQ(2, e.which());
+    TEST_EQ(45, apply_visitor(evaluator{}, e));
+
+    // Copies go in the same arena
+    expr f{e};
+    TEST_EQ(45, apply_visitor(evaluator{}, f));
+    get<mul>(&f)->lhs = 1;
+    TEST_EQ(9, apply_visitor(evaluator{}, f));
+    TEST_EQ(45, apply_visitor(evaluator{}, e));
+
+    expr g{std::move(e)};
+    TEST_EQ(45, apply_visitor(evaluator{}, g));
+
+    // Larger than a chunk
+    for (int i = 0; i < 100; ++i) {
+      g = add{std::move(g), 1};
+    }
+    TEST_EQ(145, apply_visitor(evaluator{}, g));
+  }
+
+  TEST_TRUE(arena.used() > 0);
+  arena.release();
+  TEST_EQ(0u, arena.used());
+
+  // Allocate in a particular arena, without a scope
+  expr e{emplace_tag<add>{}, std::allocator_arg, arena, add{6, 7}};
+  TEST_EQ(13, apply_visitor(evaluator{}, e));
+}
+
+/***
+ * Copies and moves go in the arena of the source, even outside of a scope
+ */
+
+expr
+build_tree(monotonic_arena & arena) {
+  arena_scope scope{arena};
+  return mul{add{2, 3}, add{4, 5}};
+}
+
+UNIT_TEST(arena_outside_scope) {
+  monotonic_arena arena;
+  expr e = build_tree(arena);
+  TEST_TRUE(!arena_scope::current());
+
+  std::size_t used = arena.used();
+  expr f{e};
+  TEST_TRUE(arena.used() > used);
+  TEST_EQ(45, apply_visitor(evaluator{}, f));
+
+  used = arena.used();
+  expr g{std::move(f)};
+  TEST_TRUE(arena.used() > used);
+  TEST_EQ(45, apply_visitor(evaluator{}, g));
+
+  std::vector<expr> vec;
+  for (int i = 0; i < 10; ++i) {
+    vec.push_back(std::move(g));
+    g = build_tree(arena);
+  }
+  for (const expr & x : vec) {
+    TEST_EQ(45, apply_visitor(evaluator{}, x));
+  }
+
+  // Not in the arena of the current scope
+  monotonic_arena other;
+  {
+    arena_scope scope{other};
+    expr h{e};
+    vec.push_back(std::move(h));
+    TEST_EQ(45, apply_visitor(evaluator{}, vec.back()));
+  }
+  TEST_EQ(0u, other.used());
+}
+
+/***
+ * Values which are not trivially destructible are destroyed on release
+ */
+
+struct counted {
+  int * count;
+  std::string name;
+
+  counted(int * c, std::string n)
+    : count(c)
+    , name(std::move(n)) {}
+  counted(counted && other) noexcept : count(other.count), name(std::move(other.name)) {}
+  counted(const counted &) = default;
+  ~counted() { ++*count; }
+};
+
+UNIT_TEST(arena_finalizers) {
+  int destroyed = 0;
+
+  monotonic_arena arena;
+  arena_scope scope{arena};
+
+  using var_t = variant<int, arena_wrapper<counted>>;
+  static_assert(std::is_trivially_destructible<var_t>::value, "failed a unit test");
+
+  {
+    var_t v{emplace_tag<counted>{}, &destroyed, "first"};
+    var_t w{emplace_tag<counted>{}, &destroyed, "second"};
+    TEST_EQ("second", get<counted>(&w)->name);
+    w = 5;
+    TEST_EQ(0, destroyed);
+  }
+  TEST_EQ(0, destroyed);
+
+  arena.release();
+  TEST_EQ(2, destroyed);
+
+  arena.release();
+  TEST_EQ(2, destroyed);
+}
+
+UNIT_TEST(arena_alignment) {
+  struct alignas(32) aligned {
+    char c;
+  };
+
+  monotonic_arena arena{64};
+  for (int i = 0; i < 10; ++i) {
+    arena.create<char>('a');
+    aligned * p = arena.create<aligned>();
+    TEST_EQ(0u, reinterpret_cast<std::uintptr_t>(p) % 32);
+  }
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Arena tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,111 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Tests of the noexcept traits of the variant, when allocations are assumed
+// not to throw
+
+#define STRICT_VARIANT_ASSUME_MOVE_NOTHROW
+#define STRICT_VARIANT_ASSUME_COPY_NOTHROW
+
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+// A throwing move, but nothrow assignment
+struct nothrow_assign {
+  int value;
+
+  nothrow_assign(int v) noexcept : value(v) {}
+  nothrow_assign(const nothrow_assign &) = default;
+  nothrow_assign(nothrow_assign && other) noexcept(false) : value(other.value) {}
+  nothrow_assign & operator=(const nothrow_assign &) noexcept = default;
+  nothrow_assign & operator=(nothrow_assign &&) noexcept = default;
+};
+
+// A throwing move and throwing assignment
+struct throwing_assign {
+  int value;
+
+  throwing_assign(int v) noexcept : value(v) {}
+  throwing_assign(const throwing_assign &) = default;
+  throwing_assign(throwing_assign && other) noexcept(false) : value(other.value) {}
+  throwing_assign & operator=(const throwing_assign & other) noexcept(false) {
+    value = other.value;
+    return *this;
+  }
+  throwing_assign & operator=(throwing_assign && other) noexcept(false) {
+    value = other.value;
+    return *this;
+  }
+};
+
+using easy_t = easy_variant<int, nothrow_assign>;
+using recursive_t = variant<int, recursive_wrapper<nothrow_assign>>;
+using throwing_t = easy_variant<int, throwing_assign>;
+
+static_assert(std::is_same<easy_t, variant<int, heap_wrapper<nothrow_assign>>>::value,
+              "failed a unit test");
+
+// Assignments of a value to a `heap_wrapper` of the same type are in place, so
+// the variant's assignments are nothrow if those of the value type are
+static_assert(std::is_nothrow_move_constructible<easy_t>::value, "failed a unit test");
+static_assert(std::is_nothrow_copy_constructible<easy_t>::value, "failed a unit test");
+static_assert(std::is_nothrow_move_assignable<easy_t>::value, "failed a unit test");
+static_assert(std::is_nothrow_copy_assignable<easy_t>::value, "failed a unit test");
+
+static_assert(!std::is_nothrow_move_assignable<throwing_t>::value, "failed a unit test");
+static_assert(!std::is_nothrow_copy_assignable<throwing_t>::value, "failed a unit test");
+
+// `compact_variant` uses `heap_wrapper` too
+struct big {
+  int values[16];
+};
+
+using compact_t = compact_variant<16, int, big>;
+
+static_assert(std::is_same<compact_t, variant<int, heap_wrapper<big>>>::value,
+              "failed a unit test");
+static_assert(std::is_nothrow_move_assignable<compact_t>::value, "failed a unit test");
+static_assert(std::is_nothrow_copy_assignable<compact_t>::value, "failed a unit test");
+
+// `recursive_wrapper` may be incomplete, so the worst is assumed
+static_assert(!std::is_nothrow_move_assignable<recursive_t>::value, "failed a unit test");
+static_assert(!std::is_nothrow_copy_assignable<recursive_t>::value, "failed a unit test");
+
+UNIT_TEST(assume_nothrow_heap_wrapper) {
+  easy_t v{nothrow_assign{5}};
+  easy_t w{7};
+
+  w = v;
+  TEST_EQ(1, w.which());
+  TEST_EQ(5, get<nothrow_assign>(&w)->value);
+
+  v = nothrow_assign{6};
+  w = std::move(v);
+  TEST_EQ(6, get<nothrow_assign>(&w)->value);
+
+  std::vector<easy_t> vec;
+  for (int i = 0; i < 10; ++i) {
+    vec.emplace_back(nothrow_assign{i});
+  }
+  for (int i = 0; i < 10; ++i) {
+    TEST_EQ(i, get<nothrow_assign>(&vec[i])->value);
+  }
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Assume nothrow tests:" << std::endl;
+  return test_registrar::run_tests();
+}
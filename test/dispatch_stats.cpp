@@ -0,0 +1,83 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#define STRICT_VARIANT_DISPATCH_STATS
+
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <string>
+
+namespace strict_variant {
+
+struct stats_visitor {
+  template <typename T>
+  int operator()(const T &) const {
+    return 1;
+  }
+};
+
+using stats_var_t = variant<int, std::string, recursive_wrapper<double>>;
+
+std::uint64_t
+stats_count(unsigned idx) {
+  return detail::stats_entry_for<int, std::string, recursive_wrapper<double>>()
+    ->counts[idx]
+    .load(std::memory_order_relaxed);
+}
+
+UNIT_TEST(dispatch_stats) {
+  stats_var_t v{5};
+  for (int i = 0; i < 7; ++i) {
+    apply_visitor(stats_visitor{}, v);
+  }
+  v = 1.5;
+  apply_visitor(stats_visitor{}, v);
+
+  // Nothing shared until the thread-local counts are flushed
+  TEST_EQ(0, stats_count(0));
+  TEST_EQ(0, stats_count(2));
+
+  flush_dispatch_stats();
+  TEST_EQ(7, stats_count(0));
+  TEST_EQ(0, stats_count(1));
+  TEST_EQ(1, stats_count(2));
+
+  // Copying and moving are internal visits, so they aren't counted, and neither
+  // are assigning a value and destroying
+  {
+    stats_var_t w{v};
+    flush_dispatch_stats();
+    TEST_EQ(1, stats_count(2));
+
+    w = std::string{"asdf"};
+    flush_dispatch_stats();
+    TEST_EQ(0, stats_count(1));
+
+    stats_var_t x{std::move(w)};
+    flush_dispatch_stats();
+    TEST_EQ(0, stats_count(1));
+  }
+  flush_dispatch_stats();
+  TEST_EQ(7, stats_count(0));
+  TEST_EQ(0, stats_count(1));
+  TEST_EQ(1, stats_count(2));
+
+  const stats_var_t & cv = v;
+  apply_visitor(stats_visitor{}, cv);
+  flush_dispatch_stats();
+  TEST_EQ(2, stats_count(2));
+
+  TEST_EQ("int", detail::stats_type_name<int>());
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Dispatch stats tests:" << std::endl;
+  return test_registrar::run_tests();
+}
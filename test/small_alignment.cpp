@@ -0,0 +1,146 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Tests of pointer tagging, when the global operator new only aligns small
+// blocks to 8 bytes, as jemalloc and tcmalloc do (and as C++17 allows)
+
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+/***
+ * Replacement allocation functions. Each block has a 16 byte header, and
+ * blocks of 8 bytes or less start 8 bytes into it, so they are 8-aligned but
+ * not 16-aligned.
+ */
+
+static void *
+small_aligned_malloc(std::size_t n) noexcept {
+  char * base = static_cast<char *>(std::malloc(n + 16));
+  if (!base) { return nullptr; }
+  return base + (n <= 8 ? 8 : 16);
+}
+
+static void
+small_aligned_free(void * p) noexcept {
+  if (!p) { return; }
+  char * c = static_cast<char *>(p);
+  std::free(c - (reinterpret_cast<std::uintptr_t>(c) % 16 == 8 ? 8 : 16));
+}
+
+void *
+operator new(std::size_t n) {
+  void * p = small_aligned_malloc(n);
+  if (!p) { throw std::bad_alloc{}; }
+  return p;
+}
+
+void *
+operator new[](std::size_t n) {
+  return ::operator new(n);
+}
+
+void *
+operator new(std::size_t n, const std::nothrow_t &) noexcept {
+  return small_aligned_malloc(n);
+}
+
+void *
+operator new[](std::size_t n, const std::nothrow_t &) noexcept {
+  return small_aligned_malloc(n);
+}
+
+void
+operator delete(void * p) noexcept {
+  small_aligned_free(p);
+}
+
+void
+operator delete[](void * p) noexcept {
+  small_aligned_free(p);
+}
+
+void
+operator delete(void * p, const std::nothrow_t &) noexcept {
+  small_aligned_free(p);
+}
+
+void
+operator delete[](void * p, const std::nothrow_t &) noexcept {
+  small_aligned_free(p);
+}
+
+void
+operator delete(void * p, std::size_t) noexcept {
+  small_aligned_free(p);
+}
+
+void
+operator delete[](void * p, std::size_t) noexcept {
+  small_aligned_free(p);
+}
+
+namespace strict_variant {
+
+template <int N>
+struct small {
+  int value;
+};
+
+using var_t = variant<recursive_wrapper<small<0>>, recursive_wrapper<small<1>>,
+                      recursive_wrapper<small<2>>, recursive_wrapper<small<3>>,
+                      recursive_wrapper<small<4>>, recursive_wrapper<small<5>>,
+                      recursive_wrapper<small<6>>, recursive_wrapper<small<7>>,
+                      recursive_wrapper<small<8>>, recursive_wrapper<small<9>>>;
+
+static_assert(sizeof(var_t) == sizeof(void *), "failed a unit test");
+
+UNIT_TEST(small_alignment_operator_new) {
+  // Check that the replacement is in use
+  void * p = ::operator new(sizeof(int));
+  TEST_EQ(8u, reinterpret_cast<std::uintptr_t>(p) % 16);
+  ::operator delete(p);
+}
+
+UNIT_TEST(small_alignment_recursive_wrapper) {
+  var_t v{small<9>{42}};
+  TEST_EQ(9, v.which());
+  TEST_EQ(42, get<small<9>>(&v)->value);
+
+  var_t w{v};
+  TEST_EQ(9, w.which());
+  TEST_EQ(42, get<small<9>>(&w)->value);
+
+  for (int i = 0; i < 10; ++i) {
+    v = small<3>{i};
+    TEST_EQ(3, v.which());
+    TEST_EQ(i, get<small<3>>(&v)->value);
+    v = small<9>{i};
+    TEST_EQ(9, v.which());
+    TEST_EQ(i, get<small<9>>(&v)->value);
+  }
+
+  v.emplace<small<7>>(small<7>{5});
+  TEST_EQ(7, v.which());
+  swap(v, w);
+  TEST_EQ(9, v.which());
+  TEST_EQ(7, w.which());
+  TEST_EQ(5, get<small<7>>(&w)->value);
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Small alignment tests:" << std::endl;
+  return test_registrar::run_tests();
+}
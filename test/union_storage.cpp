@@ -0,0 +1,151 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Tests of the recursive union storage backend (C++14)
+
+#define STRICT_VARIANT_UNION_STORAGE
+
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <string>
+#include <utility>
+
+namespace strict_variant {
+
+/***
+ * Constant expressions
+ */
+
+struct point {
+  int x;
+  int y;
+
+  constexpr point(int _x, int _y)
+    : x(_x)
+    , y(_y) {}
+};
+
+using literal_var_t = variant<int, double, point>;
+
+struct constexpr_visitor {
+  constexpr int operator()(int i) const { return i; }
+  constexpr int operator()(double d) const { return static_cast<int>(d) + 100; }
+  constexpr int operator()(const point & p) const { return p.x * p.y; }
+};
+
+constexpr int
+visit_int() {
+  return apply_visitor(constexpr_visitor{}, literal_var_t{5});
+}
+
+constexpr int
+visit_point() {
+  literal_var_t v{emplace_tag<point>{}, 3, 4};
+  return v.visit(constexpr_visitor{});
+}
+
+constexpr bool
+get_double() {
+  const literal_var_t v{2.5};
+  return get<int>(&v) == nullptr && *get<double>(&v) == 2.5 && *get<1>(&v) == 2.5;
+}
+
+constexpr literal_var_t default_var{};
+constexpr literal_var_t double_var{1.5};
+constexpr literal_var_t point_var{emplace_tag<point>{}, 6, 7};
+
+static_assert(default_var.which() == 0, "failed a unit test");
+static_assert(double_var.which() == 1, "failed a unit test");
+static_assert(point_var.which() == 2, "failed a unit test");
+static_assert(apply_visitor(constexpr_visitor{}, default_var) == 0, "failed a unit test");
+static_assert(apply_visitor(constexpr_visitor{}, double_var) == 101, "failed a unit test");
+static_assert(apply_visitor(constexpr_visitor{}, point_var) == 42, "failed a unit test");
+static_assert(visit_int() == 5, "failed a unit test");
+static_assert(visit_point() == 12, "failed a unit test");
+static_assert(get_double(), "failed a unit test");
+
+// A lookup table, built at compile time
+constexpr literal_var_t table[] = {1, 2.5, point{2, 3}, 4};
+
+constexpr int
+sum_table() {
+  int result = 0;
+  for (const auto & v : table) {
+    result += apply_visitor(constexpr_visitor{}, v);
+  }
+  return result;
+}
+
+static_assert(table[2].which() == 2, "failed a unit test");
+static_assert(sum_table() == 1 + 102 + 6 + 4, "failed a unit test");
+
+static_assert(std::is_trivially_copyable<literal_var_t>::value, "failed a unit test");
+static_assert(std::is_trivially_destructible<literal_var_t>::value, "failed a unit test");
+
+/***
+ * Runtime behavior with non-trivial types
+ */
+
+using string_var_t = variant<int, std::string, recursive_wrapper<double>>;
+
+static_assert(!std::is_trivially_destructible<string_var_t>::value, "failed a unit test");
+
+UNIT_TEST(union_storage_runtime) {
+  string_var_t v{std::string{"asdf"}};
+  TEST_EQ(1, v.which());
+  TEST_TRUE(get<std::string>(&v));
+  TEST_EQ("asdf", *get<std::string>(&v));
+
+  string_var_t w{v};
+  TEST_EQ(1, w.which());
+  TEST_EQ("asdf", *get<std::string>(&w));
+
+  v = 5;
+  TEST_EQ(0, v.which());
+  TEST_EQ(5, *get<int>(&v));
+
+  v = 1.5;
+  TEST_EQ(2, v.which());
+  TEST_EQ(1.5, *get<double>(&v));
+
+  string_var_t x{std::move(v)};
+  TEST_EQ(2, x.which());
+  TEST_EQ(1.5, *get<double>(&x));
+
+  x.emplace<std::string>("jkl");
+  TEST_EQ(1, x.which());
+  TEST_EQ("jkl", *get<std::string>(&x));
+
+  x = w;
+  TEST_EQ(1, x.which());
+  TEST_EQ("asdf", *get<std::string>(&x));
+
+  w = string_var_t{7};
+  TEST_EQ(0, w.which());
+  TEST_EQ(7, *get<int>(&w));
+}
+
+UNIT_TEST(union_storage_tagged) {
+  using tagged_var_t = variant<recursive_wrapper<int>, recursive_wrapper<std::string>>;
+  static_assert(sizeof(tagged_var_t) == sizeof(void *), "failed a unit test");
+
+  tagged_var_t v{std::string{"qwer"}};
+  TEST_EQ(1, v.which());
+  TEST_EQ("qwer", *get<std::string>(&v));
+
+  v = 3;
+  TEST_EQ(0, v.which());
+  TEST_EQ(3, *get<int>(&v));
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Union storage tests:" << std::endl;
+  return test_registrar::run_tests();
+}
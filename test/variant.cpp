@@ -3,15 +3,23 @@
 //  Distributed under the Boost Software License, Version 1.0. (See accompanying
 //  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
 
+#include <strict_variant/interpreter.hpp>
 #include <strict_variant/multivisit.hpp>
+#include <strict_variant/range_visit.hpp>
+#include <strict_variant/type_visit.hpp>
 #include <strict_variant/variant.hpp>
 #include <strict_variant/variant_stream_ops.hpp>
 
 #include "test_harness/test_harness.hpp"
 
 #include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <new>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 namespace strict_variant {
 
@@ -872,6 +880,423 @@ UNIT_TEST(easy_variant) {
   TEST_EQ(v.which(), 1);
 }
 
+// A throwing move, but nothrow assignment
+struct test_nothrow_assign {
+  int value;
+
+  test_nothrow_assign(int v) noexcept : value(v) {}
+  test_nothrow_assign(const test_nothrow_assign &) = default;
+  test_nothrow_assign(test_nothrow_assign && other) noexcept(false) : value(other.value) {}
+  test_nothrow_assign & operator=(const test_nothrow_assign &) noexcept = default;
+  test_nothrow_assign & operator=(test_nothrow_assign &&) noexcept = default;
+};
+
+UNIT_TEST(heap_wrapper) {
+  using var_t = easy_variant<test_throwmove<0>, test_nothrow_assign>;
+
+  static_assert(std::is_same<var_t, variant<heap_wrapper<test_throwmove<0>>,
+                                            heap_wrapper<test_nothrow_assign>>>::value,
+                "failed a unit test");
+  static_assert(sizeof(var_t) == sizeof(void *), "failed a unit test");
+
+  // The value type is interrogated, if the wrapper is a `heap_wrapper`
+  static_assert(detail::is_nothrow_copy_assignable<heap_wrapper<test_nothrow_assign>>::value,
+                "failed a unit test");
+  static_assert(detail::is_nothrow_move_assignable<heap_wrapper<test_nothrow_assign>>::value,
+                "failed a unit test");
+  static_assert(!detail::is_nothrow_move_assignable<heap_wrapper<test_throwmove<0>>>::value,
+                "failed a unit test");
+  static_assert(!detail::is_nothrow_copy_assignable<recursive_wrapper<test_nothrow_assign>>::value,
+                "failed a unit test");
+
+  // But copying it still allocates
+  static_assert(!detail::is_nothrow_copyable<heap_wrapper<test_nothrow_assign>>::value,
+                "failed a unit test");
+  static_assert(std::is_nothrow_move_constructible<heap_wrapper<test_throwmove<0>>>::value,
+                "failed a unit test");
+  static_assert(is_trivially_relocatable<var_t>::value, "failed a unit test");
+
+  // So at the level of the variant, copies and moves which change the type
+  // allocate, and may throw. (See assume_nothrow.cpp for when they can't.)
+  using easy_t = easy_variant<int, test_nothrow_assign>;
+  static_assert(!std::is_nothrow_move_constructible<easy_t>::value, "failed a unit test");
+  static_assert(!std::is_nothrow_move_assignable<easy_t>::value, "failed a unit test");
+  static_assert(!std::is_nothrow_copy_constructible<easy_t>::value, "failed a unit test");
+  static_assert(!std::is_nothrow_copy_assignable<easy_t>::value, "failed a unit test");
+
+  var_t v{test_nothrow_assign{5}};
+  TEST_EQ(1, v.which());
+  TEST_EQ(5, strict_variant::get<test_nothrow_assign>(&v)->value);
+  const void * ptr = strict_variant::get<test_nothrow_assign>(&v);
+
+  // Assignment of the same type is in place
+  v = test_nothrow_assign{6};
+  TEST_EQ(1, v.which());
+  TEST_EQ(6, strict_variant::get<test_nothrow_assign>(&v)->value);
+  TEST_EQ(static_cast<const void *>(strict_variant::get<test_nothrow_assign>(&v)), ptr);
+
+  var_t w{v};
+  TEST_EQ(1, w.which());
+  TEST_EQ(6, strict_variant::get<test_nothrow_assign>(&w)->value);
+
+  w = test_throwmove<0>{};
+  TEST_EQ(0, w.which());
+
+  var_t x{std::move(v)};
+  TEST_EQ(1, x.which());
+  TEST_EQ(6, strict_variant::get<test_nothrow_assign>(&x)->value);
+
+  x = std::move(w);
+  TEST_EQ(0, x.which());
+  x.emplace<test_nothrow_assign>(7);
+  TEST_EQ(1, x.which());
+  TEST_EQ(7, strict_variant::get<test_nothrow_assign>(&x)->value);
+}
+
+struct big_config {
+  int values[64];
+};
+
+UNIT_TEST(compact_variant) {
+  using var_t = compact_variant<16, int, double, big_config>;
+
+  static_assert(std::is_same<var_t, variant<int, double, heap_wrapper<big_config>>>::value,
+                "failed a unit test");
+  static_assert(sizeof(var_t) <= 16, "failed a unit test");
+
+  // The same noexcept traits as easy_variant
+  static_assert(detail::is_nothrow_copy_assignable<heap_wrapper<big_config>>::value,
+                "failed a unit test");
+  static_assert(detail::is_nothrow_move_assignable<heap_wrapper<big_config>>::value,
+                "failed a unit test");
+
+  var_t v{big_config{}};
+  TEST_EQ(v.which(), 2);
+  strict_variant::get<big_config>(&v)->values[63] = 5;
+
+  var_t w{v};
+  TEST_EQ(w.which(), 2);
+  TEST_EQ(strict_variant::get<big_config>(&w)->values[63], 5);
+
+  w = 1.5;
+  TEST_EQ(w.which(), 1);
+  w = v;
+  TEST_EQ(w.which(), 2);
+  TEST_EQ(strict_variant::get<big_config>(&w)->values[63], 5);
+}
+
+UNIT_TEST(blank) {
+  using var_t = variant<blank, int, recursive_wrapper<std::string>>;
+  using no_blank_t = variant<int, recursive_wrapper<std::string>>;
+
+  static_assert(std::is_nothrow_move_constructible<var_t>::value, "failed a unit test");
+  static_assert(!std::is_nothrow_move_constructible<no_blank_t>::value, "failed a unit test");
+
+  // The generalizing move pierces the wrapper, and may allocate
+  using super_t = variant<blank, int, recursive_wrapper<std::string>, double>;
+  static_assert(!std::is_nothrow_constructible<super_t, var_t &&>::value, "failed a unit test");
+
+  var_t v;
+  TEST_EQ(v.which(), 0);
+  v = std::string{"asdf"};
+  TEST_EQ(v.which(), 2);
+
+  // The move steals the pointer, and leaves `blank` behind
+  const std::string * ptr = strict_variant::get<std::string>(&v);
+  var_t w{std::move(v)};
+  TEST_EQ(w.which(), 2);
+  TEST_EQ(strict_variant::get<std::string>(&w), ptr);
+  TEST_EQ(*strict_variant::get<std::string>(&w), "asdf");
+  TEST_EQ(v.which(), 0);
+
+  // Other types are moved as usual
+  var_t x{5};
+  var_t y{std::move(x)};
+  TEST_EQ(y.which(), 1);
+  TEST_EQ(x.which(), 1);
+
+  // So std::vector moves rather than copies when it grows
+  std::vector<var_t> vec;
+  vec.emplace_back(std::string{"jkl"});
+  ptr = strict_variant::get<std::string>(&vec[0]);
+  for (int i = 0; i < 100; ++i) {
+    vec.emplace_back(i);
+  }
+  TEST_EQ(strict_variant::get<std::string>(&vec[0]), ptr);
+
+  TEST_TRUE(blank{} == blank{});
+  TEST_FALSE((blank{} < blank{}));
+}
+
+UNIT_TEST(move_assign_steal) {
+  // With `blank`, the target takes the pointer, and the source is left
+  // holding `blank`
+  using var_t = variant<blank, int, recursive_wrapper<std::string>, recursive_wrapper<big_config>>;
+
+  static_assert(std::is_nothrow_move_assignable<var_t>::value, "failed a unit test");
+
+  var_t v{std::string{"asdf"}};
+  const std::string * ptr = strict_variant::get<std::string>(&v);
+  var_t w{5};
+  w = std::move(v);
+  TEST_EQ(w.which(), 2);
+  TEST_EQ(strict_variant::get<std::string>(&w), ptr);
+  TEST_EQ(v.which(), 0);
+
+  // Same type
+  var_t x{std::string{"jkl"}};
+  ptr = strict_variant::get<std::string>(&x);
+  w = std::move(x);
+  TEST_EQ(w.which(), 2);
+  TEST_EQ(strict_variant::get<std::string>(&w), ptr);
+  TEST_EQ(*strict_variant::get<std::string>(&w), "jkl");
+  TEST_EQ(x.which(), 0);
+
+  // Different wrapped types
+  var_t y{big_config{}};
+  const big_config * big_ptr = strict_variant::get<big_config>(&y);
+  w = std::move(y);
+  TEST_EQ(w.which(), 3);
+  TEST_EQ(strict_variant::get<big_config>(&w), big_ptr);
+  TEST_EQ(y.which(), 0);
+
+  // Self-assignment does nothing
+  var_t & w_ref = w;
+  w = std::move(w_ref);
+  TEST_EQ(w.which(), 3);
+  TEST_EQ(strict_variant::get<big_config>(&w), big_ptr);
+
+  // Without `blank`, the value is moved into a new wrapper, and the source
+  // keeps its moved-from value
+  using no_blank_t = variant<int, recursive_wrapper<std::string>>;
+
+  static_assert(!std::is_nothrow_move_assignable<no_blank_t>::value, "failed a unit test");
+
+  no_blank_t n1{std::string{"qwer"}};
+  no_blank_t n2{7};
+  n2 = std::move(n1);
+  TEST_EQ(n2.which(), 1);
+  TEST_EQ(*strict_variant::get<std::string>(&n2), "qwer");
+  TEST_EQ(n1.which(), 1);
+}
+
+// A node of a tree, counting how many are alive
+struct steal_node;
+struct blank_steal_node;
+
+using steal_tree_t = variant<int, recursive_wrapper<steal_node>>;
+using blank_steal_tree_t = variant<blank, int, recursive_wrapper<blank_steal_node>>;
+
+template <typename Tree>
+struct counted_node {
+  Tree child;
+  static int alive;
+
+  explicit counted_node(Tree c)
+    : child(std::move(c)) {
+    ++alive;
+  }
+  counted_node(const counted_node & other)
+    : child(other.child) {
+    ++alive;
+  }
+  counted_node(counted_node && other)
+    : child(std::move(other.child)) {
+    ++alive;
+  }
+  counted_node & operator=(const counted_node &) = default;
+  counted_node & operator=(counted_node &&) = default;
+  ~counted_node() { --alive; }
+};
+
+template <typename Tree>
+int counted_node<Tree>::alive = 0;
+
+struct steal_node : counted_node<steal_tree_t> {
+  using counted_node::counted_node;
+};
+
+struct blank_steal_node : counted_node<blank_steal_tree_t> {
+  using counted_node::counted_node;
+};
+
+// Replace a node with its child, or grandchild, which the node owns
+template <typename Node, typename Tree>
+void
+check_replace_with_child() {
+  {
+    Tree e{Node{Tree{Node{Tree{3}}}}};
+    TEST_EQ(2, Node::alive);
+    e = std::move(strict_variant::get<Node>(&e)->child);
+    TEST_EQ(1, Node::alive);
+    TEST_EQ(3, *strict_variant::get<int>(&strict_variant::get<Node>(&e)->child));
+
+    e = std::move(strict_variant::get<Node>(&e)->child);
+    TEST_EQ(0, Node::alive);
+    TEST_EQ(3, *strict_variant::get<int>(&e));
+
+    e = Node{Tree{Node{Tree{Node{Tree{4}}}}}};
+    TEST_EQ(3, Node::alive);
+    e = std::move(strict_variant::get<Node>(&strict_variant::get<Node>(&e)->child)->child);
+    TEST_EQ(1, Node::alive);
+    TEST_EQ(4, *strict_variant::get<int>(&strict_variant::get<Node>(&e)->child));
+  }
+  TEST_EQ(0, Node::alive);
+}
+
+UNIT_TEST(move_assign_from_child) {
+  check_replace_with_child<steal_node, steal_tree_t>();
+  check_replace_with_child<blank_steal_node, blank_steal_tree_t>();
+}
+
+struct node_a {
+  int values[4];
+};
+
+struct node_b {
+  int values[4];
+};
+
+// Constructor which may throw
+struct node_c {
+  int values[4];
+
+  explicit node_c(int x) {
+    if (x < 0) { throw x; }
+    values[0] = x;
+  }
+};
+
+UNIT_TEST(heap_node_reuse) {
+  using var_t = variant<int, recursive_wrapper<node_a>, recursive_wrapper<node_b>,
+                        recursive_wrapper<node_c>, recursive_wrapper<big_config>>;
+
+  var_t v{node_a{{1, 2, 3, 4}}};
+  const void * ptr = strict_variant::get<node_a>(&v);
+
+  // Same type
+  v.emplace<node_a>(node_a{{5, 6, 7, 8}});
+  TEST_EQ(v.which(), 1);
+  TEST_EQ(static_cast<const void *>(strict_variant::get<node_a>(&v)), ptr);
+  TEST_EQ(strict_variant::get<node_a>(&v)->values[0], 5);
+
+  // Different type of the same size and alignment
+  v.emplace<node_b>(node_b{{9, 10, 11, 12}});
+  TEST_EQ(v.which(), 2);
+  TEST_EQ(static_cast<const void *>(strict_variant::get<node_b>(&v)), ptr);
+  TEST_EQ(strict_variant::get<node_b>(&v)->values[3], 12);
+
+  // Type-changing assignment
+  v = node_a{{13, 14, 15, 16}};
+  TEST_EQ(v.which(), 1);
+  TEST_EQ(static_cast<const void *>(strict_variant::get<node_a>(&v)), ptr);
+  TEST_EQ(strict_variant::get<node_a>(&v)->values[1], 14);
+
+  // The constructor may throw, so the value is made on the stack first
+  v.emplace<node_c>(17);
+  TEST_EQ(v.which(), 3);
+  TEST_EQ(static_cast<const void *>(strict_variant::get<node_c>(&v)), ptr);
+  TEST_EQ(strict_variant::get<node_c>(&v)->values[0], 17);
+
+  // If it throws, the old value is still there
+  bool caught = false;
+  try {
+    v.emplace<node_b>(node_b{{18, 19, 20, 21}});
+    v.emplace<node_c>(-1);
+  } catch (int) { caught = true; }
+  TEST_TRUE(caught);
+  TEST_EQ(v.which(), 2);
+  TEST_EQ(static_cast<const void *>(strict_variant::get<node_b>(&v)), ptr);
+  TEST_EQ(strict_variant::get<node_b>(&v)->values[0], 18);
+
+  // Different size, a new allocation is made
+  v.emplace<big_config>();
+  TEST_EQ(v.which(), 4);
+  v = 5;
+  TEST_EQ(v.which(), 0);
+  v = node_b{{22, 23, 24, 25}};
+  TEST_EQ(v.which(), 2);
+  TEST_EQ(strict_variant::get<node_b>(&v)->values[0], 22);
+}
+
+struct alias_a {
+  int a;
+  int b;
+};
+
+// `e` is written first, over the old `a`
+struct alias_b {
+  int e;
+  int d;
+
+  explicit alias_b(const int & x) noexcept
+    : e(0)
+    , d(x) {}
+};
+
+UNIT_TEST(heap_node_reuse_alias) {
+  using var_t = variant<recursive_wrapper<alias_a>, recursive_wrapper<alias_b>>;
+
+  // The argument refers into the value being replaced
+  var_t v{alias_a{7, 8}};
+  v.emplace<1>(strict_variant::get<alias_a>(&v)->a);
+  TEST_EQ(v.which(), 1);
+  TEST_EQ(strict_variant::get<alias_b>(&v)->d, 7);
+}
+
+// Same layout as `node_a`, but with class-specific allocation functions
+struct pooled_node {
+  int values[4];
+  static int allocated;
+
+  static void * operator new(std::size_t size) {
+    ++allocated;
+    return std::malloc(size);
+  }
+
+  static void operator delete(void * p) noexcept {
+    --allocated;
+    std::free(p);
+  }
+};
+
+int pooled_node::allocated = 0;
+
+UNIT_TEST(heap_node_reuse_class_allocation) {
+  using var_t = variant<heap_wrapper<node_a>, heap_wrapper<pooled_node>>;
+
+  static_assert(!detail::wrapper_reuse::compatible<heap_wrapper<pooled_node>,
+                                                   heap_wrapper<node_a>>::value,
+                "failed a unit test");
+  static_assert(!detail::wrapper_reuse::compatible<heap_wrapper<node_a>,
+                                                   heap_wrapper<pooled_node>>::value,
+                "failed a unit test");
+  static_assert(detail::wrapper_reuse::compatible<heap_wrapper<pooled_node>,
+                                                  heap_wrapper<pooled_node>>::value,
+                "failed a unit test");
+
+  {
+    var_t v{pooled_node{{1, 2, 3, 4}}};
+    TEST_EQ(1, pooled_node::allocated);
+    const void * ptr = strict_variant::get<pooled_node>(&v);
+
+    // Same type, the node is reused
+    v.emplace<pooled_node>(pooled_node{{5, 6, 7, 8}});
+    TEST_EQ(1, pooled_node::allocated);
+    TEST_EQ(static_cast<const void *>(strict_variant::get<pooled_node>(&v)), ptr);
+
+    // Different type, the node goes back to `pooled_node::operator delete`
+    v.emplace<node_a>(node_a{{9, 10, 11, 12}});
+    TEST_EQ(0, pooled_node::allocated);
+    TEST_EQ(strict_variant::get<node_a>(&v)->values[0], 9);
+
+    v.emplace<pooled_node>(pooled_node{{13, 14, 15, 16}});
+    TEST_EQ(1, pooled_node::allocated);
+    TEST_EQ(strict_variant::get<pooled_node>(&v)->values[0], 13);
+  }
+  TEST_EQ(0, pooled_node::allocated);
+}
+
 struct test_eq {
   template <typename T, typename U>
   bool operator()(const T & t, const U & u) const {
@@ -904,6 +1329,57 @@ UNIT_TEST(multivisit) {
   TEST_EQ(true, apply_visitor(test_eq{}, v1, v2));
 }
 
+struct pair_index_visitor {
+  template <typename T>
+  static int index(const T &) {
+    return 0;
+  }
+  static int index(const std::string &) { return 1; }
+  static int index(const double &) { return 2; }
+
+  template <typename T, typename U>
+  int operator()(const T & t, const U & u) const {
+    return 3 * index(t) + index(u);
+  }
+
+  // Rvalues are forwarded to the visitor
+  template <typename T>
+  int operator()(const T &, std::string &&) const {
+    return -1;
+  }
+};
+
+UNIT_TEST(flat_multivisit) {
+  using var1_t = variant<int, std::string, recursive_wrapper<double>>;
+  using var2_t = variant<bool, std::string, double>;
+
+  var1_t v1{5};
+  var2_t v2{true};
+  const pair_index_visitor vis{};
+
+  for (int i = 0; i < 3; ++i) {
+    switch (i) {
+      case 0: v1 = 5; break;
+      case 1: v1 = std::string{"asdf"}; break;
+      default: v1 = 1.5; break;
+    }
+    TEST_EQ(v1.which(), i);
+    for (int j = 0; j < 3; ++j) {
+      switch (j) {
+        case 0: v2 = false; break;
+        case 1: v2 = std::string{"jkl"}; break;
+        default: v2 = 2.5; break;
+      }
+      TEST_EQ(v2.which(), j);
+      TEST_EQ(3 * i + j, apply_visitor(vis, v1, v2));
+      TEST_EQ(3 * i + j, apply_visitor(vis, static_cast<const var1_t &>(v1), v2));
+    }
+  }
+
+  v2 = std::string{"jkl"};
+  TEST_EQ(-1, apply_visitor(vis, v1, std::move(v2)));
+}
+
 UNIT_TEST(generalizing_ctor) {
   using var_1_t = variant<int, bool>;
   using var_2_t = variant<bool, int>;
@@ -1161,6 +1637,876 @@ UNIT_TEST(variant_swap) {
   }
 }
 
+namespace dispatch_test {
+
+template <unsigned N>
+struct item {};
+
+template <typename Policy>
+struct first {};
+
+template <typename Policy>
+using var_t = variant<first<Policy>, item<1>, item<2>, item<3>, item<4>, item<5>, item<6>,
+                      std::string, item<8>, item<9>, item<10>, item<11>>;
+
+struct visitor {
+  template <unsigned N>
+  unsigned operator()(const item<N> &) const {
+    return N;
+  }
+  template <typename P>
+  unsigned operator()(const first<P> &) const {
+    return 0;
+  }
+  unsigned operator()(const std::string &) const { return 7; }
+};
+
+template <typename Policy>
+void
+check_policy() {
+  var_t<Policy> v;
+  TEST_EQ(0u, apply_visitor(visitor{}, v));
+  v = item<4>{};
+  TEST_EQ(4u, apply_visitor(visitor{}, v));
+  v = std::string{"foo"};
+  TEST_EQ(7u, apply_visitor(visitor{}, v));
+  var_t<Policy> w{v};
+  TEST_EQ(7u, apply_visitor(visitor{}, w));
+  v = item<11>{};
+  TEST_EQ(11u, apply_visitor(visitor{}, v));
+  swap(v, w);
+  TEST_EQ(7u, apply_visitor(visitor{}, v));
+  TEST_EQ(11u, apply_visitor(visitor{}, w));
+  w = item<1>{};
+  TEST_EQ(1u, apply_visitor(visitor{}, w));
+}
+
+template <typename UL>
+struct big_variant;
+
+template <unsigned... us>
+struct big_variant<mpl::ulist<us...>> {
+  using type = variant<item<us>...>;
+};
+
+// Big enough that switch_table needs more than one chunk
+using big_var_t = typename big_variant<mpl::count_t<150>>::type;
+
+} // end namespace dispatch_test
+
+template <typename Policy>
+struct dispatch_policy<dispatch_test::var_t<Policy>> {
+  using type = Policy;
+};
+
+template <>
+struct dispatch_policy<dispatch_test::big_var_t> {
+  using type = dispatch::switch_table;
+};
+
+namespace dispatch_test {
+
+template <unsigned N>
+void
+check_big_variant(big_var_t & v) {
+  v = item<N>{};
+  TEST_EQ(N, apply_visitor(visitor{}, v));
+}
+
+} // end namespace dispatch_test
+
+UNIT_TEST(dispatch_policies) {
+  dispatch_test::check_policy<dispatch::binary_search>();
+  dispatch_test::check_policy<dispatch::jumptable>();
+  dispatch_test::check_policy<dispatch::linear>();
+  dispatch_test::check_policy<dispatch::switch_table>();
+  dispatch_test::check_policy<dispatch::hybrid<4>>();
+  dispatch_test::check_policy<dispatch::hybrid<4, dispatch::linear, dispatch::binary_search>>();
+  dispatch_test::check_policy<dispatch::default_policy>();
+  dispatch_test::check_policy<dispatch::likely<dispatch::binary_search, 7, 0>>();
+  dispatch_test::check_policy<dispatch::likely<dispatch::linear, 11>>();
+  dispatch_test::check_policy<dispatch::branchless<>>();
+
+  dispatch_test::big_var_t v;
+  TEST_EQ(0u, apply_visitor(dispatch_test::visitor{}, v));
+  dispatch_test::check_big_variant<1>(v);
+  dispatch_test::check_big_variant<63>(v);
+  dispatch_test::check_big_variant<64>(v);
+  dispatch_test::check_big_variant<65>(v);
+  dispatch_test::check_big_variant<127>(v);
+  dispatch_test::check_big_variant<128>(v);
+  dispatch_test::check_big_variant<149>(v);
+  dispatch_test::big_var_t w{v};
+  TEST_EQ(149u, apply_visitor(dispatch_test::visitor{}, w));
+}
+
+struct which_visitor {
+  int operator()(int) const { return 0; }
+  int operator()(const std::string &) const { return 1; }
+  int operator()(double) const { return 2; }
+};
+
+UNIT_TEST(apply_visitor_with) {
+  using var_t = variant<int, std::string, double>;
+  using hint_t = dispatch::likely<dispatch::default_policy, 2>;
+
+  var_t v{5.5};
+  TEST_EQ(2, apply_visitor_with<hint_t>(which_visitor{}, v));
+  v = "foo";
+  TEST_EQ(1, apply_visitor_with<hint_t>(which_visitor{}, v));
+  v = 5;
+  TEST_EQ(0, apply_visitor_with<hint_t>(which_visitor{}, static_cast<const var_t &>(v)));
+  TEST_EQ(0, apply_visitor_with<dispatch::jumptable>(which_visitor{}, std::move(v)));
+}
+
+// Size of the discriminator
+
+static_assert(std::is_same<int, decltype(std::declval<variant<char, bool>>().which())>::value,
+              "failed a unit test");
+static_assert(sizeof(variant<char, bool>) == 2, "failed a unit test");
+static_assert(sizeof(variant<std::int32_t, float>) == 8, "failed a unit test");
+static_assert(
+  std::is_same<unsigned char, discriminator_type<dispatch_test::big_var_t>::type>::value,
+  "failed a unit test");
+
+using wide_tag_var_t = variant<char, signed char>;
+
+template <>
+struct discriminator_type<wide_tag_var_t> {
+  using type = unsigned int;
+};
+
+static_assert(sizeof(wide_tag_var_t) == 2 * sizeof(unsigned int), "failed a unit test");
+
+UNIT_TEST(discriminator_type) {
+  wide_tag_var_t v{'a'};
+  TEST_EQ(0, v.which());
+  v = static_cast<signed char>(5);
+  TEST_EQ(1, v.which());
+  wide_tag_var_t w{v};
+  TEST_EQ(1, w.which());
+
+  variant<char, bool> x{true};
+  TEST_EQ(1, x.which());
+  x = 'a';
+  TEST_EQ(0, x.which());
+}
+
+/***
+ * Iterative destruction of deep structures
+ */
+
+struct deep_node;
+struct deep_pair;
+
+using deep_list = variant<int, recursive_wrapper<deep_node>, recursive_wrapper<deep_pair>>;
+
+struct deep_node {
+  static int destroyed;
+
+  int value;
+  deep_list next;
+
+  explicit deep_node(int v)
+    : value(v)
+    , next(0) {}
+  ~deep_node() { ++destroyed; }
+};
+
+int deep_node::destroyed = 0;
+
+template <>
+struct iterative_destruction<deep_node> : std::true_type {};
+
+// Not opted in, but its children are
+struct deep_pair {
+  deep_list first;
+  deep_list second;
+};
+
+UNIT_TEST(iterative_destruction) {
+  deep_node::destroyed = 0;
+
+  // Deep enough to overflow the stack if it were destroyed recursively
+  const int length = 1000000;
+  {
+    deep_list head{0};
+    deep_list * tail = &head;
+    for (int i = 0; i < length; ++i) {
+      tail->emplace<deep_node>(i);
+      tail = &strict_variant::get<deep_node>(tail)->next;
+    }
+    TEST_EQ(0, deep_node::destroyed);
+  }
+  TEST_EQ(length, deep_node::destroyed);
+
+  // Mixed with wrappers which are destroyed recursively
+  {
+    deep_list head{0};
+    deep_list * tail = &head;
+    for (int i = 0; i < length; ++i) {
+      if (i % 3) {
+        tail->emplace<deep_node>(i);
+        tail = &strict_variant::get<deep_node>(tail)->next;
+      } else {
+        tail->emplace<deep_pair>(deep_pair{deep_node{i}, 0});
+        tail = &strict_variant::get<deep_pair>(tail)->second;
+      }
+    }
+    deep_node::destroyed = 0;
+  }
+  TEST_EQ(length, deep_node::destroyed);
+
+  // Assignment destroys the old value iteratively too
+  deep_node::destroyed = 0;
+  {
+    deep_list head{0};
+    deep_list * tail = &head;
+    for (int i = 0; i < length; ++i) {
+      tail->emplace<deep_node>(i);
+      tail = &strict_variant::get<deep_node>(tail)->next;
+    }
+    head = 5;
+    TEST_EQ(length, deep_node::destroyed);
+  }
+}
+
+using tagged_var_t =
+  variant<recursive_wrapper<int>, recursive_wrapper<std::string>, recursive_wrapper<double>>;
+
+static_assert(sizeof(tagged_var_t) == sizeof(void *), "failed a unit test");
+static_assert(sizeof(variant<recursive_wrapper<int>, int>) > sizeof(void *), "failed a unit test");
+
+UNIT_TEST(pointer_tag) {
+  tagged_var_t v{5};
+  TEST_EQ(0, v.which());
+  TEST_TRUE(strict_variant::get<int>(&v));
+  TEST_EQ(5, *strict_variant::get<int>(&v));
+
+  v = std::string{"asdf"};
+  TEST_EQ(1, v.which());
+  TEST_EQ("asdf", *strict_variant::get<std::string>(&v));
+
+  tagged_var_t w{v};
+  TEST_EQ(1, w.which());
+  TEST_EQ("asdf", *strict_variant::get<std::string>(&w));
+
+  w = 7.5;
+  TEST_EQ(2, w.which());
+  TEST_EQ(1, v.which());
+  TEST_EQ(7.5, *strict_variant::get<double>(&w));
+
+  tagged_var_t x{std::move(w)};
+  TEST_EQ(2, x.which());
+  TEST_EQ(7.5, *strict_variant::get<double>(&x));
+
+  x = v;
+  TEST_EQ(1, x.which());
+  TEST_TRUE(x == v);
+
+  x.emplace<int>(9);
+  TEST_EQ(0, x.which());
+  TEST_EQ(0, apply_visitor(which_visitor{}, x));
+
+  v = std::move(x);
+  TEST_EQ(0, v.which());
+  TEST_EQ(9, *strict_variant::get<int>(&v));
+}
+
+// Its class-specific allocation functions only align to 8 bytes
+struct misaligned_node {
+  int value;
+  static int allocated;
+
+  explicit misaligned_node(int v)
+    : value(v) {}
+
+  static void * operator new(std::size_t size) {
+    ++allocated;
+    return static_cast<char *>(::operator new(size + 8)) + 8;
+  }
+
+  static void operator delete(void * p) noexcept {
+    --allocated;
+    ::operator delete(static_cast<char *>(p) - 8);
+  }
+};
+
+int misaligned_node::allocated = 0;
+
+static_assert(detail::has_class_allocation<misaligned_node>::value, "failed a unit test");
+static_assert(!detail::has_class_allocation<std::string>::value, "failed a unit test");
+static_assert(!detail::has_class_allocation<int>::value, "failed a unit test");
+
+UNIT_TEST(pointer_tag_class_allocation) {
+  // `recursive_wrapper` ignores the class-specific allocation functions, so
+  // it can still be tagged
+  using rw_var_t = variant<recursive_wrapper<misaligned_node>, recursive_wrapper<std::string>>;
+  static_assert(sizeof(rw_var_t) == sizeof(void *), "failed a unit test");
+  {
+    rw_var_t v{misaligned_node{5}};
+    TEST_EQ(0, v.which());
+    TEST_EQ(5, strict_variant::get<misaligned_node>(&v)->value);
+    TEST_EQ(0, misaligned_node::allocated);
+    v = std::string{"asdf"};
+    TEST_EQ(1, v.which());
+  }
+
+  // `heap_wrapper` uses them, so it isn't tagged
+  using hw_var_t = variant<heap_wrapper<misaligned_node>, heap_wrapper<std::string>>;
+  static_assert(sizeof(hw_var_t) > sizeof(void *), "failed a unit test");
+  {
+    hw_var_t v{misaligned_node{5}};
+    TEST_EQ(0, v.which());
+    TEST_EQ(5, strict_variant::get<misaligned_node>(&v)->value);
+    TEST_EQ(1, misaligned_node::allocated);
+
+    hw_var_t w{std::move(v)};
+    TEST_EQ(0, w.which());
+    TEST_EQ(5, strict_variant::get<misaligned_node>(&w)->value);
+
+    v = std::string{"asdf"};
+    TEST_EQ(1, v.which());
+    TEST_EQ(1, misaligned_node::allocated);
+  }
+  TEST_EQ(0, misaligned_node::allocated);
+}
+
+struct telemetry {
+  int id;
+  float value;
+};
+
+using trivial_var_t = variant<int, double, telemetry>;
+
+static_assert(detail::is_trivially_copyable<trivial_var_t>::value, "failed a unit test");
+static_assert(!detail::is_trivially_copyable<variant<int, std::string>>::value,
+              "failed a unit test");
+static_assert(!detail::is_trivially_copyable<variant<int, recursive_wrapper<int>>>::value,
+              "failed a unit test");
+static_assert(std::is_nothrow_copy_constructible<trivial_var_t>::value, "failed a unit test");
+static_assert(std::is_nothrow_move_assignable<trivial_var_t>::value, "failed a unit test");
+
+UNIT_TEST(trivially_copyable) {
+  trivial_var_t v{telemetry{3, 1.5f}};
+  TEST_EQ(2, v.which());
+
+  trivial_var_t w{v};
+  TEST_EQ(2, w.which());
+  TEST_EQ(3, strict_variant::get<telemetry>(&w)->id);
+
+  w = 5;
+  TEST_EQ(0, w.which());
+  TEST_EQ(2, v.which());
+
+  v = std::move(w);
+  TEST_EQ(0, v.which());
+  TEST_EQ(5, *strict_variant::get<int>(&v));
+
+  w = 2.5;
+  v.swap(w);
+  TEST_EQ(1, v.which());
+  TEST_EQ(0, w.which());
+  TEST_EQ(2.5, *strict_variant::get<double>(&v));
+  TEST_EQ(5, *strict_variant::get<int>(&w));
+
+  std::vector<trivial_var_t> vec;
+  for (int i = 0; i < 100; ++i) {
+    if (i % 2) {
+      vec.emplace_back(i);
+    } else {
+      vec.emplace_back(telemetry{i, 0.0f});
+    }
+  }
+  for (int i = 0; i < 100; ++i) {
+    TEST_EQ(i % 2 ? 0 : 2, vec[static_cast<std::size_t>(i)].which());
+  }
+}
+
+// Trivially destructible, but not trivially copyable
+struct counted_copy {
+  static int copies;
+
+  int value;
+
+  explicit counted_copy(int v) noexcept
+    : value(v) {}
+  counted_copy(const counted_copy & other) noexcept
+    : value(other.value) {
+    ++copies;
+  }
+  counted_copy & operator=(const counted_copy & other) noexcept {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+};
+
+int counted_copy::copies = 0;
+
+using trivial_dtor_var_t = variant<int, counted_copy>;
+
+static_assert(std::is_trivially_destructible<trivial_dtor_var_t>::value, "failed a unit test");
+static_assert(!detail::is_trivially_copyable<trivial_dtor_var_t>::value, "failed a unit test");
+static_assert(!std::is_trivially_destructible<variant<int, std::string>>::value,
+              "failed a unit test");
+
+UNIT_TEST(trivially_destructible) {
+  trivial_dtor_var_t v{counted_copy{4}};
+  TEST_EQ(1, v.which());
+  counted_copy::copies = 0;
+
+  trivial_dtor_var_t w{v};
+  TEST_EQ(1, w.which());
+  TEST_EQ(1, counted_copy::copies);
+
+  w = 5;
+  TEST_EQ(0, w.which());
+  w = v;
+  TEST_EQ(1, w.which());
+  TEST_EQ(4, strict_variant::get<counted_copy>(&w)->value);
+
+  w.emplace<int>(7);
+  TEST_EQ(0, w.which());
+  TEST_EQ(7, *strict_variant::get<int>(&w));
+}
+
+// Pure, and total over any bit pattern: out-of-range doubles (and NaN) are
+// never converted to int.
+struct arith_visitor {
+  int operator()(int i) const noexcept { return i; }
+  int operator()(double d) const noexcept {
+    return (d > -1000 && d < 1000) ? static_cast<int>(d * 2) : 0;
+  }
+  int operator()(bool b) const noexcept { return b ? 100 : 200; }
+};
+
+template <>
+struct branchless_safe<arith_visitor> : std::true_type {};
+
+// Not noexcept, so branchless must fall back
+struct throwing_arith_visitor {
+  int operator()(int i) const { return i; }
+  int operator()(double d) const { return (d > -1000 && d < 1000) ? static_cast<int>(d * 2) : 0; }
+  int operator()(bool b) const { return b ? 100 : 200; }
+};
+
+template <>
+struct branchless_safe<throwing_arith_visitor> : std::true_type {};
+
+// Not opted in, so branchless must fall back. Evaluating the `int *` overload
+// on the bytes of an `int` would crash.
+struct deref_visitor {
+  int operator()(int i) const noexcept { return i; }
+  int operator()(int * p) const noexcept { return *p; }
+};
+
+// Not opted in either, since it has side effects
+struct counting_visitor {
+  int & calls;
+
+  int operator()(int i) const noexcept { return ++calls, i; }
+  int operator()(double) const noexcept { return ++calls, 0; }
+  int operator()(bool) const noexcept { return ++calls, 0; }
+};
+
+UNIT_TEST(branchless_dispatch) {
+  using var_t = variant<int, double, bool>;
+  using policy_t = dispatch::branchless<>;
+  using storage_t = detail::storage<int, double, bool>;
+
+  using dispatcher_t = policy_t::dispatcher_t<int, detail::false_, 3>;
+  static_assert(dispatcher_t::eligible<storage_t, arith_visitor>::value, "failed a unit test");
+  static_assert(dispatcher_t::eligible<storage_t, const arith_visitor>::value,
+                "failed a unit test");
+  static_assert(!dispatcher_t::eligible<storage_t, throwing_arith_visitor>::value,
+                "failed a unit test");
+  static_assert(!dispatcher_t::eligible<storage_t, counting_visitor>::value, "failed a unit test");
+  static_assert(!dispatcher_t::eligible<detail::storage<int, int *>, deref_visitor>::value,
+                "failed a unit test");
+  static_assert(!policy_t::dispatcher_t<int, detail::true_, 3>::eligible<storage_t,
+                                                                          arith_visitor>::value,
+                "failed a unit test");
+  static_assert(
+    !dispatcher_t::eligible<detail::storage<int, recursive_wrapper<double>, bool>,
+                            arith_visitor>::value,
+    "failed a unit test");
+
+  var_t v{5};
+  TEST_EQ(5, apply_visitor_with<policy_t>(arith_visitor{}, v));
+  TEST_EQ(5, apply_visitor_with<policy_t>(throwing_arith_visitor{}, v));
+  v = 2.5;
+  TEST_EQ(5, apply_visitor_with<policy_t>(arith_visitor{}, v));
+  TEST_EQ(5, apply_visitor_with<policy_t>(throwing_arith_visitor{}, v));
+  v = 1e300;
+  TEST_EQ(0, apply_visitor_with<policy_t>(arith_visitor{}, v));
+  v = true;
+  TEST_EQ(100, apply_visitor_with<policy_t>(arith_visitor{}, v));
+  v = false;
+  TEST_EQ(200, apply_visitor_with<policy_t>(arith_visitor{}, static_cast<const var_t &>(v)));
+  TEST_EQ(200, apply_visitor_with<policy_t>(throwing_arith_visitor{}, std::move(v)));
+
+  int calls = 0;
+  v = 3;
+  TEST_EQ(3, apply_visitor_with<policy_t>(counting_visitor{calls}, v));
+  TEST_EQ(1, calls);
+
+  variant<int, int *> w{12345};
+  TEST_EQ(12345, apply_visitor_with<policy_t>(deref_visitor{}, w));
+  int x = 7;
+  w = &x;
+  TEST_EQ(7, apply_visitor_with<policy_t>(deref_visitor{}, w));
+}
+
+struct range_visitor {
+  std::string log;
+
+  void operator()(int i) { log += std::to_string(i); }
+  void operator()(const std::string & s) { log += s; }
+  void operator()(double) { log += "d"; }
+};
+
+struct range_which_visitor {
+  int operator()(int) const { return 0; }
+  int operator()(const std::string &) const { return 1; }
+  int operator()(double) const { return 2; }
+};
+
+UNIT_TEST(apply_visitor_range) {
+  using var_t = variant<int, std::string, recursive_wrapper<double>>;
+
+  std::vector<var_t> vec;
+  vec.emplace_back(1);
+  vec.emplace_back(2);
+  vec.emplace_back(std::string{"a"});
+  vec.emplace_back(1.5);
+  vec.emplace_back(2.5);
+  vec.emplace_back(3);
+  vec.emplace_back(std::string{"b"});
+  vec.emplace_back(std::string{"c"});
+
+  // Grouped by type
+  {
+    range_visitor vis;
+    apply_visitor_range(vis, vec.begin(), vec.end());
+    TEST_EQ(vis.log, "123abcdd");
+  }
+
+  {
+    range_visitor vis;
+    const std::vector<var_t> & cvec = vec;
+    apply_visitor_range(vis, cvec.begin() + 1, cvec.end() - 1);
+    TEST_EQ(vis.log, "23abdd");
+  }
+
+  {
+    range_visitor vis;
+    apply_visitor_range(vis, vec.begin(), vec.begin());
+    TEST_EQ(vis.log, "");
+  }
+
+  {
+    std::vector<int> results(vec.size() + 1);
+    auto it = apply_visitor_range(range_which_visitor{}, vec.begin(), vec.end(), results.begin());
+    *it = 7;
+    std::vector<int> expected{0, 0, 1, 2, 2, 0, 1, 1, 7};
+    TEST_TRUE(results == expected);
+  }
+
+  // Long enough to be counted in several chunks, with a remainder
+  {
+    std::vector<var_t> long_vec;
+    for (int i = 0; i < 103; ++i) {
+      if (i % 3 == 0 || i > 90) {
+        long_vec.emplace_back(i);
+      } else if (i % 3 == 1) {
+        long_vec.emplace_back(std::to_string(i % 10));
+      } else {
+        long_vec.emplace_back(0.5);
+      }
+    }
+
+    range_visitor grouped;
+    apply_visitor_range(grouped, long_vec.begin(), long_vec.end());
+
+    range_visitor ints, strings, doubles;
+    for (const var_t & v : long_vec) {
+      switch (v.which()) {
+        case 0: apply_visitor(ints, v); break;
+        case 1: apply_visitor(strings, v); break;
+        default: apply_visitor(doubles, v); break;
+      }
+    }
+    TEST_EQ(grouped.log, ints.log + strings.log + doubles.log);
+
+    std::vector<int> results(long_vec.size());
+    std::vector<int> expected;
+    apply_visitor_range(range_which_visitor{}, long_vec.begin(), long_vec.end(), results.begin());
+    apply_visitor_range(in_order_tag{}, range_which_visitor{}, long_vec.begin(), long_vec.end(),
+                        std::back_inserter(expected));
+    TEST_TRUE(results == expected);
+  }
+
+  // In order
+  {
+    range_visitor vis;
+    apply_visitor_range(in_order_tag{}, vis, vec.begin(), vec.end());
+    TEST_EQ(vis.log, "12add3bc");
+  }
+
+  {
+    range_visitor vis;
+    const std::vector<var_t> & cvec = vec;
+    apply_visitor_range(in_order_tag{}, vis, cvec.begin() + 1, cvec.end() - 1);
+    TEST_EQ(vis.log, "2add3b");
+  }
+
+  {
+    range_visitor vis;
+    apply_visitor_range(in_order_tag{}, vis, vec.begin(), vec.begin());
+    TEST_EQ(vis.log, "");
+  }
+
+  {
+    std::vector<int> results;
+    auto it = apply_visitor_range(in_order_tag{}, range_which_visitor{}, vec.begin(), vec.end(),
+                                  std::back_inserter(results));
+    *it = 7;
+    std::vector<int> expected{0, 0, 1, 2, 2, 0, 1, 1, 7};
+    TEST_TRUE(results == expected);
+  }
+}
+
+struct type_name_visitor {
+  constexpr const char * operator()(type_tag<int>) const { return "int"; }
+  constexpr const char * operator()(type_tag<std::string>) const { return "string"; }
+  constexpr const char * operator()(type_tag<double>) const { return "double"; }
+};
+
+struct size_visitor {
+  template <typename T>
+  constexpr std::size_t operator()(type_tag<T>) const {
+    return sizeof(T);
+  }
+};
+
+UNIT_TEST(apply_type_visitor) {
+  using var_t = variant<int, std::string, recursive_wrapper<double>>;
+
+  static_assert(detail::type_table<size_visitor, var_t>::values[2] == sizeof(double),
+                "type_table should be a constant expression, and pierce wrappers");
+
+  var_t v{5};
+  TEST_EQ(std::string{"int"}, apply_type_visitor<type_name_visitor>(v));
+  TEST_EQ(sizeof(int), apply_type_visitor<size_visitor>(v));
+  v = std::string{"asdf"};
+  TEST_EQ(std::string{"string"}, apply_type_visitor<type_name_visitor>(v));
+  TEST_EQ(sizeof(std::string), apply_type_visitor<size_visitor>(v));
+  v = 1.5;
+  TEST_EQ(std::string{"double"}, apply_type_visitor<type_name_visitor>(v));
+  TEST_EQ(sizeof(double), apply_type_visitor<size_visitor>(v));
+}
+
+namespace interp_test {
+
+struct push {
+  int value;
+};
+struct add {};
+struct dup {};
+struct dec {};
+struct jump_if_nonzero {
+  int offset;
+};
+struct halt {};
+
+using instruction = variant<push, add, dup, dec, jump_if_nonzero, halt>;
+
+struct machine {
+  std::vector<int> stack;
+  int steps = 0;
+
+  int pop() {
+    int result = stack.back();
+    stack.pop_back();
+    return result;
+  }
+
+  int operator()(const push & p) {
+    ++steps;
+    stack.push_back(p.value);
+    return 1;
+  }
+  int operator()(add) {
+    ++steps;
+    int x = pop();
+    stack.back() += x;
+    return 1;
+  }
+  int operator()(dup) {
+    ++steps;
+    stack.push_back(stack.back());
+    return 1;
+  }
+  int operator()(dec) {
+    ++steps;
+    --stack.back();
+    return 1;
+  }
+  int operator()(const jump_if_nonzero & j) {
+    ++steps;
+    return pop() ? j.offset : 1;
+  }
+  int operator()(halt) {
+    ++steps;
+    return 1000;
+  }
+};
+
+} // end namespace interp_test
+
+UNIT_TEST(interpret) {
+  using namespace interp_test;
+
+  std::vector<instruction> program{push{1}, push{2}, add{}, halt{}, push{3}};
+
+  {
+    machine m;
+    TEST_EQ(static_cast<std::ptrdiff_t>(1003), interpret(m, program.begin(), program.end()));
+    TEST_EQ(4, m.steps);
+    TEST_EQ(1u, m.stack.size());
+    TEST_EQ(3, m.stack.back());
+  }
+
+  {
+    // Start from the end, run off of the end of the program
+    machine m;
+    TEST_EQ(static_cast<std::ptrdiff_t>(5), interpret(m, program.cbegin(), program.cend(), 4));
+    TEST_EQ(1, m.steps);
+  }
+
+  {
+    // Loop: count down from 3 with dup / dec / jump_if_nonzero
+    std::vector<instruction> loop{push{3}, dec{}, dup{}, jump_if_nonzero{-2}};
+    machine m;
+    TEST_EQ(static_cast<std::ptrdiff_t>(4), interpret(m, loop.begin(), loop.end()));
+    TEST_EQ(1 + 3 * 3, m.steps);
+    TEST_EQ(1u, m.stack.size());
+    TEST_EQ(0, m.stack.back());
+  }
+
+  {
+    // Empty program
+    std::vector<instruction> empty;
+    machine m;
+    TEST_EQ(static_cast<std::ptrdiff_t>(0), interpret(m, empty.begin(), empty.end()));
+    TEST_EQ(0, m.steps);
+  }
+}
+
+/***
+ * Trivial relocation
+ */
+
+// A type which owns a heap allocation, and opts in to trivial relocation
+struct owning_ptr {
+  int * ptr;
+
+  explicit owning_ptr(int i)
+    : ptr(new int(i)) {}
+  owning_ptr(owning_ptr && other) noexcept : ptr(other.ptr) { other.ptr = nullptr; }
+  owning_ptr(const owning_ptr &) = delete;
+  owning_ptr & operator=(owning_ptr && other) noexcept {
+    std::swap(ptr, other.ptr);
+    return *this;
+  }
+  ~owning_ptr() { delete ptr; }
+};
+
+template <>
+struct is_trivially_relocatable<owning_ptr> : std::true_type {};
+
+static_assert(is_trivially_relocatable<int>::value, "failed a unit test");
+static_assert(is_trivially_relocatable<recursive_wrapper<std::string>>::value,
+              "failed a unit test");
+static_assert(!is_trivially_relocatable<std::string>::value, "failed a unit test");
+static_assert(is_trivially_relocatable<variant<int, recursive_wrapper<std::string>>>::value,
+              "failed a unit test");
+static_assert(is_trivially_relocatable<variant<int, owning_ptr>>::value, "failed a unit test");
+static_assert(!is_trivially_relocatable<variant<int, std::string>>::value, "failed a unit test");
+static_assert(!std::is_trivially_copyable<variant<int, owning_ptr>>::value, "failed a unit test");
+
+UNIT_TEST(trivial_relocation) {
+  {
+    using var_t = variant<int, owning_ptr>;
+
+    var_t x{5};
+    var_t y{emplace_tag<owning_ptr>{}, 7};
+    swap(x, y);
+    TEST_EQ(1, x.which());
+    TEST_EQ(7, *get<owning_ptr>(&x)->ptr);
+    TEST_EQ(0, y.which());
+    TEST_EQ(5, *get<int>(&y));
+
+    x.swap(x);
+    TEST_EQ(1, x.which());
+    TEST_EQ(7, *get<owning_ptr>(&x)->ptr);
+  }
+
+  {
+    using var_t = variant<int, recursive_wrapper<std::string>>;
+    constexpr std::size_t n = 10;
+
+    alignas(var_t) unsigned char buffer_a[n * sizeof(var_t)];
+    alignas(var_t) unsigned char buffer_b[n * sizeof(var_t)];
+    var_t * a = reinterpret_cast<var_t *>(buffer_a);
+    var_t * b = reinterpret_cast<var_t *>(buffer_b);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      if (i % 2) {
+        new (a + i) var_t{std::to_string(i)};
+      } else {
+        new (a + i) var_t{static_cast<int>(i)};
+      }
+    }
+
+    TEST_EQ(b + n, relocate(a, a + n, b));
+
+    for (std::size_t i = 0; i < n; ++i) {
+      TEST_EQ(static_cast<int>(i % 2), b[i].which());
+      if (i % 2) {
+        TEST_EQ(std::to_string(i), *get<std::string>(b + i));
+      } else {
+        TEST_EQ(static_cast<int>(i), *get<int>(b + i));
+      }
+      b[i].~var_t();
+    }
+  }
+
+  {
+    // Not trivially relocatable, so it falls back to move and destroy
+    using var_t = variant<int, std::string>;
+    constexpr std::size_t n = 4;
+
+    alignas(var_t) unsigned char buffer_a[n * sizeof(var_t)];
+    alignas(var_t) unsigned char buffer_b[n * sizeof(var_t)];
+    var_t * a = reinterpret_cast<var_t *>(buffer_a);
+    var_t * b = reinterpret_cast<var_t *>(buffer_b);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      new (a + i) var_t{std::string(20, static_cast<char>('a' + i))};
+    }
+
+    TEST_EQ(b + n, relocate(a, a + n, b));
+
+    for (std::size_t i = 0; i < n; ++i) {
+      TEST_EQ(1, b[i].which());
+      TEST_EQ(std::string(20, static_cast<char>('a' + i)), *get<std::string>(b + i));
+      b[i].~var_t();
+    }
+  }
+}
+
 } // end namespace strict_variant
 
 int